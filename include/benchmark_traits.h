@@ -17,19 +17,33 @@ struct SupportsQueueProfiling<T,
   static constexpr bool value = true;
 };
 
+// Benchmarks whose run time does not depend on the local size (e.g. single_task or copy-only benchmarks)
+// declare `static constexpr bool usesLocalSize = false;` and are not swept by the local size autotuning.
+template <typename T, typename = void>
+struct UsesLocalSize {
+  static constexpr bool value = true;
+};
+
+template <typename T>
+struct UsesLocalSize<T, std::void_t<decltype(T::usesLocalSize)>> {
+  static constexpr bool value = T::usesLocalSize;
+};
+
 #define MAKE_HAS_METHOD_TRAIT(T, method, name)                                                                         \
   template <typename _T>                                                                                               \
   static constexpr std::false_type _has_##method(...);                                                                 \
   template <typename _T>                                                                                               \
-  static constexpr std::true_type _has_##method(_T, decltype(&_T::method) = nullptr);                                  \
-  static constexpr bool name = std::is_same_v<decltype(_has_##method<T>(std::declval<T>())), std::true_type>;
+  static constexpr std::true_type _has_##method(_T*, decltype(&_T::method) = nullptr);                                 \
+  static constexpr bool name = std::is_same_v<decltype(_has_##method<T>(std::declval<T*>())), std::true_type>;
 
 template <typename T>
 struct BenchmarkTraits {
   MAKE_HAS_METHOD_TRAIT(T, verify, hasVerify)
   MAKE_HAS_METHOD_TRAIT(T, getThroughputMetric, hasGetThroughputMetric)
+  MAKE_HAS_METHOD_TRAIT(T, getLatencyMetric, hasGetLatencyMetric)
 
   static constexpr bool supportsQueueProfiling = SupportsQueueProfiling<T>::value;
+  static constexpr bool usesLocalSize = UsesLocalSize<T>::value;
 };
 
 } // namespace detail
@@ -160,6 +160,8 @@ struct BenchmarkArgs
 {
   size_t problem_size;
   size_t local_size;
+  // set by --local=auto; the BenchmarkApp will then sweep all legal local sizes
+  bool autotune_local_size;
   size_t num_runs;
   cl::sycl::queue device_queue;
   VerificationSetting verification;
@@ -189,7 +191,12 @@ public:
   BenchmarkArgs getBenchmarkArgs() const
   {
     std::size_t size = cli_parser.getOrDefault<std::size_t>("--size", 3072);
-    std::size_t local_size = cli_parser.getOrDefault<std::size_t>("--local", 256);
+    std::size_t local_size = 256;
+    bool autotune_local_size = false;
+    if(cli_parser.getOrDefault<std::string>("--local", "") == "auto")
+      autotune_local_size = true;
+    else
+      local_size = cli_parser.getOrDefault<std::size_t>("--local", 256);
     std::size_t num_runs = cli_parser.getOrDefault<std::size_t>("--num-runs", 5);
 
     std::string device_type = cli_parser.getOrDefault<std::string>("--device", "default");
@@ -210,6 +217,7 @@ public:
 
     return BenchmarkArgs{size,
                          local_size,
+                         autotune_local_size,
                          num_runs,
                          q,
                          VerificationSetting{verification_enabled,
@@ -38,8 +38,9 @@ public:
     hooks.push_back(&h);
   }
 
+  // Returns the fastest measured run time, or nothing if verification failed.
   template<typename... Args>
-  void run(Args&&... additionalArgs)
+  std::optional<std::chrono::nanoseconds> run(Args&&... additionalArgs)
   {
     args.result_consumer->proceedToBenchmark(Benchmark{args, additionalArgs...}.getBenchmarkName());
 
@@ -53,7 +54,7 @@ public:
     args.result_consumer->consumeResult(
       "sycl-implementation", this->getSyclImplementation());
 
-    TimeMetricsProcessor<Benchmark> time_metrics(args);
+    TimeMetricsProcessor<Benchmark> time_metrics(args, Benchmark{args, additionalArgs...});
 
     for(auto h : hooks) h->atInit();
 
@@ -142,7 +143,10 @@ public:
     }        
     
     args.result_consumer->flush();
-    
+
+    if(!all_runs_pass)
+      return std::nullopt;
+    return time_metrics.getMinimum("run-time");
   }
 
 private:
@@ -172,6 +176,7 @@ class BenchmarkApp
   BenchmarkArgs args;  
   cl::sycl::queue device_queue;
   std::unordered_set<std::string> benchmark_names;
+  std::optional<std::size_t> last_local_size;
   
 public:  
   BenchmarkApp(int argc, char** argv)
@@ -196,9 +201,15 @@ public:
 
   bool deviceSupportsFP64() const { return deviceHasAspect(cl::sycl::aspect::fp64); }
 
+  // Local size of the last successful run, i.e. the best one when autotuning the local size.
+  std::optional<std::size_t> getLastLocalSize() const { return last_local_size; }
+
+  // Returns the fastest run time (the best one when autotuning the local size),
+  // or nothing if the benchmark failed.
   template<class Benchmark, typename... AdditionalArgs>
-  void run(AdditionalArgs&&... additional_args)
+  std::optional<std::chrono::nanoseconds> run(AdditionalArgs&&... additional_args)
   {
+    last_local_size.reset();
     try {
       const auto name = Benchmark{args, additional_args...}.getBenchmarkName();
       if(benchmark_names.count(name) == 0) {
@@ -208,14 +219,13 @@ public:
         throw std::runtime_error("Duplicate benchmark name");
       }
 
-      BenchmarkManager<Benchmark> mgr(args);
-
-#ifdef NV_ENERGY_MEAS
-      NVEnergyMeasurement nvem;
-      mgr.addHook(nvem);
-#endif
+      if(args.autotune_local_size && detail::BenchmarkTraits<Benchmark>::usesLocalSize)
+        return autotuneLocalSize<Benchmark>(name, additional_args...);
 
-      mgr.run(additional_args...);
+      const auto time = runWithArgs<Benchmark>(args, additional_args...);
+      if(time)
+        last_local_size = args.local_size;
+      return time;
     }
     catch(cl::sycl::exception& e){
       std::cerr << "SYCL error: " << e.what() << std::endl;
@@ -223,5 +233,94 @@ public:
     catch(std::exception& e){
       std::cerr << "Error: " << e.what() << std::endl;
     }
+    return std::nullopt;
+  }
+
+private:
+  template<class Benchmark, typename... AdditionalArgs>
+  std::optional<std::chrono::nanoseconds> runWithArgs(const BenchmarkArgs& benchmark_args,
+                                                      AdditionalArgs&&... additional_args)
+  {
+    BenchmarkManager<Benchmark> mgr(benchmark_args);
+
+#ifdef NV_ENERGY_MEAS
+    NVEnergyMeasurement nvem;
+    mgr.addHook(nvem);
+#endif
+
+    return mgr.run(additional_args...);
+  }
+
+  // Power-of-two local sizes that divide the problem size and are supported by the device.
+  // A local size of 1 is left out, as the multi-pass reductions would never terminate with it.
+  std::vector<std::size_t> getLocalSizeCandidates() const
+  {
+    const std::size_t max_local_size = args.device_queue.get_device()
+        .template get_info<cl::sycl::info::device::max_work_group_size>();
+
+    std::vector<std::size_t> candidates;
+    for(std::size_t local_size = 2; local_size <= max_local_size && local_size <= args.problem_size; local_size *= 2) {
+      if(args.problem_size % local_size == 0)
+        candidates.push_back(local_size);
+    }
+    return candidates;
+  }
+
+  // Runs the benchmark once for every local size candidate (each emitting its regular results)
+  // and finally emits the best local size together with the full local size vs. time curve.
+  template<class Benchmark, typename... AdditionalArgs>
+  std::optional<std::chrono::nanoseconds> autotuneLocalSize(const std::string& name,
+                                                            AdditionalArgs&&... additional_args)
+  {
+    std::optional<std::size_t> best_local_size;
+    std::chrono::nanoseconds best_time{0};
+    std::stringstream curve;
+
+    for(std::size_t local_size : getLocalSizeCandidates()) {
+      BenchmarkArgs candidate_args = args;
+      candidate_args.local_size = local_size;
+
+      std::optional<std::chrono::nanoseconds> time;
+      try {
+        time = runWithArgs<Benchmark>(candidate_args, additional_args...);
+      }
+      catch(cl::sycl::exception& e) {
+        // Some local sizes may exceed kernel-specific limits (e.g. local memory), just skip them.
+        std::cerr << "SYCL error for local size " << local_size << ": " << e.what() << std::endl;
+      }
+      catch(std::exception& e) {
+        std::cerr << "Error for local size " << local_size << ": " << e.what() << std::endl;
+      }
+
+      if(!curve.str().empty())
+        curve << " ";
+      curve << local_size << ":";
+      if(time) {
+        curve << std::to_string(time->count() / 1.0e9);
+        if(!best_local_size || *time < best_time) {
+          best_local_size = local_size;
+          best_time = *time;
+        }
+      } else {
+        curve << "N/A";
+      }
+    }
+
+    args.result_consumer->proceedToBenchmark(name + "_LocalSizeAutotuning");
+    args.result_consumer->consumeResult("problem-size", std::to_string(args.problem_size));
+    if(best_local_size) {
+      args.result_consumer->consumeResult("best-local-size", std::to_string(*best_local_size));
+      args.result_consumer->consumeResult("best-run-time-min", std::to_string(best_time.count() / 1.0e9), "s");
+    } else {
+      args.result_consumer->consumeResult("best-local-size", "N/A");
+      args.result_consumer->consumeResult("best-run-time-min", "N/A");
+    }
+    args.result_consumer->consumeResult("run-time-min-per-local-size", "\"" + curve.str() + "\"");
+    args.result_consumer->flush();
+
+    if(!best_local_size)
+      return std::nullopt;
+    last_local_size = best_local_size;
+    return best_time;
   }
 };
@@ -0,0 +1,57 @@
+#ifndef SEGMENT_LENGTHS_H
+#define SEGMENT_LENGTHS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+// Distribution of the segment lengths for segmented patterns:
+//  * Uniform: lengths uniformly distributed in [1, 2 * mean_length - 1].
+//  * Exponential: geometrically distributed lengths with the given mean.
+//  * PowerLaw: Pareto distributed lengths (alpha = 1.2) with the given mean, i.e. mostly
+//    short segments and a few huge ones. The lengths are capped at a quarter of the total size.
+enum class SegmentDistribution { Uniform, Exponential, PowerLaw };
+
+inline std::string getSegmentDistributionName(SegmentDistribution distribution) {
+  switch(distribution) {
+  case SegmentDistribution::Uniform: return "Uniform";
+  case SegmentDistribution::Exponential: return "Exponential";
+  case SegmentDistribution::PowerLaw: return "PowerLaw";
+  }
+  return "";
+}
+
+// Generates the offsets of non-empty segments covering [0, total_size), in CSR format:
+// segment i spans [offsets[i], offsets[i + 1]) and offsets.back() == total_size.
+inline std::vector<std::size_t> generateSegmentOffsets(
+    SegmentDistribution distribution, std::size_t total_size, std::size_t mean_length, unsigned seed = 42) {
+  std::mt19937 rng{seed};
+  std::uniform_int_distribution<std::size_t> uniform{1, std::max<std::size_t>(2 * mean_length - 1, 1)};
+  std::geometric_distribution<std::size_t> geometric{1.0 / std::max<std::size_t>(mean_length, 1)};
+  std::uniform_real_distribution<double> unit{0.0, 1.0};
+
+  const double alpha = 1.2;
+  const double min_power_law_length = mean_length * (alpha - 1.0) / alpha;
+  const std::size_t max_power_law_length = std::max<std::size_t>(total_size / 4, 1);
+
+  std::vector<std::size_t> offsets{0};
+  while(offsets.back() < total_size) {
+    std::size_t length = 1;
+    switch(distribution) {
+    case SegmentDistribution::Uniform: length = uniform(rng); break;
+    case SegmentDistribution::Exponential: length = 1 + geometric(rng); break;
+    case SegmentDistribution::PowerLaw: {
+      const double pareto = min_power_law_length * std::pow(1.0 - unit(rng), -1.0 / alpha);
+      length = static_cast<std::size_t>(std::min<double>(pareto, static_cast<double>(max_power_law_length)));
+      break;
+    }
+    }
+    offsets.push_back(std::min(offsets.back() + std::max<std::size_t>(length, 1), total_size));
+  }
+  return offsets;
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cmath>
 #include <numeric>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -22,16 +23,37 @@
  * Note that the metric is NOT the throughput. For example, a returned metric
  * for arithmetric throughput could be the total number of floating-point operations,
  * FLOP, not FLOP/s.
+ *
+ * getThroughputMetric() may either be static or a const member function, the latter
+ * being useful for benchmarks that receive additional constructor arguments.
  */
 struct ThroughputMetric {
   double metric = 0.0;
   std::string unit = "";
 };
 
+/**
+ * Latency metrics can be returned by benchmarks that implement the
+ * getLatencyMetric() function. The returned value is the number of operations
+ * that were executed one after another, e.g. the number of dependent loads,
+ * and the latency is reported as time per operation.
+ */
+struct LatencyMetric {
+  double operations = 0.0;
+  std::string unit = "";
+};
+
 template <typename Benchmark>
 class TimeMetricsProcessor {
 public:
-  TimeMetricsProcessor(const BenchmarkArgs& args) : args(args) {}
+  TimeMetricsProcessor(const BenchmarkArgs& args, const Benchmark& benchmark) : args(args) {
+    if constexpr(detail::BenchmarkTraits<Benchmark>::hasGetThroughputMetric) {
+      benchmarkThroughputMetric = benchmark.getThroughputMetric(args);
+    }
+    if constexpr(detail::BenchmarkTraits<Benchmark>::hasGetLatencyMetric) {
+      benchmarkLatencyMetric = benchmark.getLatencyMetric(args);
+    }
+  }
 
   void addTimingResult(const std::string& name, std::chrono::nanoseconds time) {
     if(unavailableTimings.count(name) != 0) {
@@ -53,11 +75,18 @@ public:
     unavailableTimings.insert(name);
   }
 
+  std::optional<std::chrono::nanoseconds> getMinimum(const std::string& name) const {
+    if(timingResults.count(name) == 0) {
+      return std::nullopt;
+    }
+    return *std::min_element(timingResults.at(name).begin(), timingResults.at(name).end());
+  }
+
   void emitResults(ResultConsumer& consumer) const {
     // Begin by outputting the throughput metric (if available), as this does not depend on a timing.
     if constexpr(detail::BenchmarkTraits<Benchmark>::hasGetThroughputMetric) {
-      const auto tpm = Benchmark::getThroughputMetric(args);
-      consumer.consumeResult("throughput-metric", std::to_string(tpm.metric), tpm.unit);
+      consumer.consumeResult(
+          "throughput-metric", std::to_string(benchmarkThroughputMetric.metric), benchmarkThroughputMetric.unit);
     } else {
       consumer.consumeResult("throughput-metric", "N/A", "");
     }
@@ -118,16 +147,24 @@ public:
         std::string unit = "";
         if constexpr(detail::BenchmarkTraits<Benchmark>::hasGetThroughputMetric) {
           const double min = resultsSeconds[0];
-          const auto tpm = Benchmark::getThroughputMetric(args);
-          throughputMetric = tpm.metric;
+          throughputMetric = benchmarkThroughputMetric.metric;
           throughput = throughputMetric / min;
-          unit = tpm.unit;
+          unit = benchmarkThroughputMetric.unit;
         }
         if(throughputMetric > 0.0) {
           consumer.consumeResult(name + "-throughput", std::to_string(throughput), unit + "/s");
         } else {
           consumer.consumeResult(name + "-throughput", "N/A", "");
         }
+
+        if constexpr(detail::BenchmarkTraits<Benchmark>::hasGetLatencyMetric) {
+          if(benchmarkLatencyMetric.operations > 0.0) {
+            const double latency = resultsSeconds[0] * 1.0e9 / benchmarkLatencyMetric.operations;
+            consumer.consumeResult(name + "-latency", std::to_string(latency), "ns/" + benchmarkLatencyMetric.unit);
+          } else {
+            consumer.consumeResult(name + "-latency", "N/A", "");
+          }
+        }
       } else {
         // Now the hacky part: Emit columns also for unavailable timings.
         // FIXME: Come up with a cleaner solution.
@@ -137,12 +174,17 @@ public:
         consumer.consumeResult(name + "-min", "N/A");
         consumer.consumeResult(name + "-samples", "N/A");
         consumer.consumeResult(name + "-throughput", "N/A");
+        if constexpr(detail::BenchmarkTraits<Benchmark>::hasGetLatencyMetric) {
+          consumer.consumeResult(name + "-latency", "N/A");
+        }
       }
     }
   }
 
 private:
   const BenchmarkArgs args;
+  ThroughputMetric benchmarkThroughputMetric;
+  LatencyMetric benchmarkLatencyMetric;
   std::unordered_map<std::string, std::vector<std::chrono::nanoseconds>> timingResults;
   std::unordered_set<std::string> unavailableTimings;
 };
@@ -1,6 +1,8 @@
 #ifndef TYPE_TRAITS_H
 #define TYPE_TRAITS_H
 
+#include <CL/sycl.hpp>
+
 template<class T>
 struct ReadableTypename
 {};
@@ -11,6 +13,7 @@ struct ReadableTypename<T> \
 { static const char* name; }; const char* ReadableTypename<T>::name = str;
 
 MAKE_READABLE_TYPENAME(char, "int8")
+MAKE_READABLE_TYPENAME(signed char, "int8")
 MAKE_READABLE_TYPENAME(unsigned char, "uint8")
 MAKE_READABLE_TYPENAME(short, "int16")
 MAKE_READABLE_TYPENAME(unsigned short, "uint16")
@@ -18,6 +21,7 @@ MAKE_READABLE_TYPENAME(int, "int32")
 MAKE_READABLE_TYPENAME(unsigned int, "uint32")
 MAKE_READABLE_TYPENAME(long long, "int64")
 MAKE_READABLE_TYPENAME(unsigned long long, "uint64")
+MAKE_READABLE_TYPENAME(cl::sycl::half, "fp16")
 MAKE_READABLE_TYPENAME(float, "fp32")
 MAKE_READABLE_TYPENAME(double, "fp64")
 
@@ -2,7 +2,12 @@
 
 namespace s = cl::sycl;
 
-template <typename DataT, int Dims>
+// STREAM-style memory kernels. With a, b being input buffers and q a scalar, these compute:
+//   Read:  sink(a)      Write: out = q        Copy:  out = a
+//   Scale: out = q * a  Add:   out = a + b    Triad: out = a + q * b
+enum class DRAMOp { Read, Write, Copy, Scale, Add, Triad };
+
+template <typename DataT, int Dims, DRAMOp Op>
 class MicroBenchDRAMKernel;
 
 template <typename DataT, int Dims>
@@ -22,62 +27,143 @@ s::range<Dims> getBufferSize(size_t problemSize) {
 }
 
 /**
- * Microbenchmark measuring DRAM bandwidth.
+ * Microbenchmark measuring DRAM bandwidth for the set of STREAM kernels (plus read-only and write-only variants).
+ *
+ * Throughput is reported in the STREAM convention, i.e. counting each byte read and written once.
  */
-template <typename DataT, int Dims>
+template <typename DataT, int Dims, DRAMOp Op>
 class MicroBenchDRAM {
 protected:
+  static constexpr DataT A_VALUE = 33;
+  static constexpr DataT B_VALUE = 2;
+  static constexpr DataT SCALAR = 3;
+
   BenchmarkArgs args;
   const s::range<Dims> buffer_size;
-  // Since we cannot use explicit memory operations to initialize the input buffer,
-  // we have to keep this around, unfortunately.
-  std::vector<DataT> input;
-  PrefetchedBuffer<DataT, Dims> input_buf;
+  // Since we cannot use explicit memory operations to initialize the input buffers,
+  // we have to keep these around, unfortunately.
+  std::vector<DataT> input_a;
+  std::vector<DataT> input_b;
+  PrefetchedBuffer<DataT, Dims> input_a_buf;
+  PrefetchedBuffer<DataT, Dims> input_b_buf;
   PrefetchedBuffer<DataT, Dims> output_buf;
 
 public:
+  // The kernels run over basic ranges
+  static constexpr bool usesLocalSize = false;
+
   MicroBenchDRAM(const BenchmarkArgs& args)
-      : args(args), buffer_size(getBufferSize<DataT, Dims>(args.problem_size)), input(buffer_size.size(), 33.f) {}
+      : args(args), buffer_size(getBufferSize<DataT, Dims>(args.problem_size)) {}
 
   void setup() {
-    input_buf.initialize(args.device_queue, input.data(), buffer_size);
+    if constexpr(Op != DRAMOp::Write) {
+      input_a.resize(buffer_size.size(), A_VALUE);
+      input_a_buf.initialize(args.device_queue, input_a.data(), buffer_size);
+    }
+    if constexpr(Op == DRAMOp::Add || Op == DRAMOp::Triad) {
+      input_b.resize(buffer_size.size(), B_VALUE);
+      input_b_buf.initialize(args.device_queue, input_b.data(), buffer_size);
+    }
     output_buf.initialize(args.device_queue, buffer_size);
   }
 
+  // Number of buffers that are read or written by the kernel, each of which is accessed once per element.
+  static constexpr int getNumAccessedBuffers() {
+    switch(Op) {
+    case DRAMOp::Read:
+    case DRAMOp::Write: return 1;
+    case DRAMOp::Copy:
+    case DRAMOp::Scale: return 2;
+    case DRAMOp::Add:
+    case DRAMOp::Triad: return 3;
+    }
+    return 0;
+  }
+
   static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
-    const double copiedGiB =
+    const double bufferGiB =
         getBufferSize<DataT, Dims>(args.problem_size).size() * sizeof(DataT) / 1024.0 / 1024.0 / 1024.0;
-    // Multiply by two as we are both reading and writing one element in each thread.
-    return {copiedGiB * 2.0, "GiB"};
+    return {bufferGiB * getNumAccessedBuffers(), "GiB"};
   }
 
   void run(std::vector<s::event>& events) {
     events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
-      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
-      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
-      // We spawn one work item for each buffer element to be copied.
+      // We spawn one work item for each buffer element.
       const s::range<Dims> global_size{buffer_size};
-      cgh.parallel_for<MicroBenchDRAMKernel<DataT, Dims>>(global_size, [=](s::id<Dims> gid) { out[gid] = in[gid]; });
+      const DataT q = SCALAR;
+
+      if constexpr(Op == DRAMOp::Read) {
+        auto a = input_a_buf.template get_access<s::access::mode::read>(cgh);
+        auto out = output_buf.template get_access<s::access::mode::write>(cgh);
+        cgh.parallel_for<MicroBenchDRAMKernel<DataT, Dims, Op>>(global_size, [=](s::id<Dims> gid) {
+          // The store is never executed, but prevents the compiler from eliminating the load.
+          const DataT v = a[gid];
+          if(v == q)
+            out[gid] = v;
+        });
+      }
+      if constexpr(Op == DRAMOp::Write) {
+        auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+        cgh.parallel_for<MicroBenchDRAMKernel<DataT, Dims, Op>>(global_size, [=](s::id<Dims> gid) { out[gid] = q; });
+      }
+      if constexpr(Op == DRAMOp::Copy || Op == DRAMOp::Scale) {
+        auto a = input_a_buf.template get_access<s::access::mode::read>(cgh);
+        auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+        cgh.parallel_for<MicroBenchDRAMKernel<DataT, Dims, Op>>(global_size, [=](s::id<Dims> gid) {
+          if constexpr(Op == DRAMOp::Copy)
+            out[gid] = a[gid];
+          else
+            out[gid] = q * a[gid];
+        });
+      }
+      if constexpr(Op == DRAMOp::Add || Op == DRAMOp::Triad) {
+        auto a = input_a_buf.template get_access<s::access::mode::read>(cgh);
+        auto b = input_b_buf.template get_access<s::access::mode::read>(cgh);
+        auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+        cgh.parallel_for<MicroBenchDRAMKernel<DataT, Dims, Op>>(global_size, [=](s::id<Dims> gid) {
+          if constexpr(Op == DRAMOp::Add)
+            out[gid] = a[gid] + b[gid];
+          else
+            out[gid] = a[gid] + q * b[gid];
+        });
+      }
     }));
   }
 
+  static constexpr DataT getExpectedValue() {
+    switch(Op) {
+    case DRAMOp::Write: return SCALAR;
+    case DRAMOp::Copy: return A_VALUE;
+    case DRAMOp::Scale: return SCALAR * A_VALUE;
+    case DRAMOp::Add: return A_VALUE + B_VALUE;
+    case DRAMOp::Triad: return A_VALUE + SCALAR * B_VALUE;
+    default: return DataT{0};
+    }
+  }
+
   bool verify(VerificationSetting& ver) {
+    // The read-only kernel produces no output
+    if constexpr(Op == DRAMOp::Read) {
+      return true;
+    }
+
+    const DataT expected = getExpectedValue();
     auto result = output_buf.template get_access<s::access::mode::read>();
     for(size_t i = 0; i < buffer_size[0]; ++i) {
       for(size_t j = 0; j < (Dims < 2 ? 1 : buffer_size[1]); ++j) {
         for(size_t k = 0; k < (Dims < 3 ? 1 : buffer_size[2]); ++k) {
           if constexpr(Dims == 1) {
-            if(result[i] != 33.f) {
+            if(result[i] != expected) {
               return false;
             }
           }
           if constexpr(Dims == 2) {
-            if(result[{i, j}] != 33.f) {
+            if(result[{i, j}] != expected) {
               return false;
             }
           }
           if constexpr(Dims == 3) {
-            if(result[{i, j, k}] != 33.f) {
+            if(result[{i, j, k}] != expected) {
               return false;
             }
           }
@@ -87,25 +173,51 @@ public:
     return true;
   }
 
+  static std::string getOpName() {
+    switch(Op) {
+    case DRAMOp::Read: return "Read";
+    case DRAMOp::Write: return "Write";
+    case DRAMOp::Copy: return "Copy";
+    case DRAMOp::Scale: return "Scale";
+    case DRAMOp::Add: return "Add";
+    case DRAMOp::Triad: return "Triad";
+    }
+    return "";
+  }
+
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "MicroBench_DRAM_";
+    name << getOpName() << "_";
     name << ReadableTypename<DataT>::name;
     name << "_" << Dims;
     return name.str();
   }
 };
 
+template <typename DataT, DRAMOp Op>
+void runDRAMBenchmarks(BenchmarkApp& app) {
+  app.run<MicroBenchDRAM<DataT, 1, Op>>();
+  app.run<MicroBenchDRAM<DataT, 2, Op>>();
+  app.run<MicroBenchDRAM<DataT, 3, Op>>();
+}
+
+template <typename DataT>
+void runDRAMBenchmarks(BenchmarkApp& app) {
+  runDRAMBenchmarks<DataT, DRAMOp::Read>(app);
+  runDRAMBenchmarks<DataT, DRAMOp::Write>(app);
+  runDRAMBenchmarks<DataT, DRAMOp::Copy>(app);
+  runDRAMBenchmarks<DataT, DRAMOp::Scale>(app);
+  runDRAMBenchmarks<DataT, DRAMOp::Add>(app);
+  runDRAMBenchmarks<DataT, DRAMOp::Triad>(app);
+}
+
 int main(int argc, char** argv) {
   BenchmarkApp app(argc, argv);
 
-  app.run<MicroBenchDRAM<float, 1>>();
-  app.run<MicroBenchDRAM<float, 2>>();
-  app.run<MicroBenchDRAM<float, 3>>();
+  runDRAMBenchmarks<float>(app);
   if(app.deviceSupportsFP64()) {
-    app.run<MicroBenchDRAM<double, 1>>();
-    app.run<MicroBenchDRAM<double, 2>>();
-    app.run<MicroBenchDRAM<double, 3>>();
+    runDRAMBenchmarks<double>(app);
   }
 
   return 0;
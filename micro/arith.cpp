@@ -2,13 +2,20 @@
 
 namespace s = cl::sycl;
 
-template <typename DataT, int Iterations>
+template <typename DataT, int Chains, int Iterations>
 class MicroBenchArithmeticKernel;
 
 /**
  * Microbenchmark stressing the main arithmetic units.
+ *
+ * Every work item runs Chains independent chains of multiply-add operations.
+ * With a single chain, every operation depends on the previous one, so the run time is
+ * dominated by the latency of the arithmetic units. More chains expose instruction level parallelism
+ * within a work item, which is required to reach the peak throughput on many architectures.
+ * On CPU backends, comparing both shows whether the compiler vectorizes across work items.
+ * Every chain starts from its own input element, so the compiler cannot merge the chains.
  */
-template <typename DataT, int Iterations = 512>
+template <typename DataT, int Chains = 1, int Iterations = 512>
 class MicroBenchArithmetic {
 protected:
   std::vector<DataT> input;
@@ -18,6 +25,9 @@ protected:
   PrefetchedBuffer<DataT, 1> output_buf;
 
 public:
+  // The kernel runs over a basic range
+  static constexpr bool usesLocalSize = false;
+
   MicroBenchArithmetic(const BenchmarkArgs& _args) : args(_args) {}
 
   void setup() {
@@ -28,22 +38,18 @@ public:
   }
 
   static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+    // Two multiply-adds per iteration and chain, each counting as two operations.
+    const double OP = static_cast<double>(args.problem_size) * Iterations * Chains * 2 * 2;
+    if constexpr(std::is_same_v<DataT, s::half>) {
+      return {OP / 1024.0 / 1024.0 / 1024.0, "HP GFLOP"};
+    }
     if constexpr(std::is_same_v<DataT, float>) {
-      // Multiply everything times two as we are doing FMAs.
-      const double FLOP = args.problem_size * Iterations * 2 * 2;
-      return {FLOP / 1024.0 / 1024.0 / 1024.0, "SP GFLOP"};
+      return {OP / 1024.0 / 1024.0 / 1024.0, "SP GFLOP"};
     }
     if constexpr(std::is_same_v<DataT, double>) {
-      // Multiply everything times two as we are doing FMAs.
-      const double DFLOP = args.problem_size * Iterations * 2 * 2;
-      return {DFLOP / 1024.0 / 1024.0 / 1024.0, "DP GFLOP"};
+      return {OP / 1024.0 / 1024.0 / 1024.0, "DP GFLOP"};
     }
-    if constexpr(std::is_same_v<DataT, int>) {
-      // Multiply everything times two as we are doing MAD.
-      const double OP = args.problem_size * Iterations * 2 * 2;
-      return {OP / 1024.0 / 1024.0 / 1024.0, "GOP"};
-    }
-    return {};
+    return {OP / 1024.0 / 1024.0 / 1024.0, "GOP"};
   }
 
   void run(std::vector<cl::sycl::event>& events) {
@@ -51,18 +57,29 @@ public:
       auto in = input_buf.template get_access<s::access::mode::read>(cgh);
       auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
 
-      cgh.parallel_for<MicroBenchArithmeticKernel<DataT, Iterations>>(
+      const std::size_t n = args.problem_size;
+
+      cgh.parallel_for<MicroBenchArithmeticKernel<DataT, Chains, Iterations>>(
           s::range<1>{args.problem_size}, [=](cl::sycl::id<1> gid) {
-            DataT a1 = in[gid];
-            const DataT a2 = a1;
+            const DataT a2 = in[gid];
+            DataT a1[Chains];
+            for(int c = 0; c < Chains; ++c) {
+              a1[c] = in[(gid[0] + c) % n];
+            }
 
-            for(int i = 0; i < 512; ++i) {
-              // We do two operations to ensure the value remains 1 and doesn't grow indefinitely.
-              a1 = a1 * a1 + a1;
-              a1 = a1 * a2 - a2;
+            for(int i = 0; i < Iterations; ++i) {
+              for(int c = 0; c < Chains; ++c) {
+                // We do two operations to ensure the value remains 1 and doesn't grow indefinitely.
+                a1[c] = a1[c] * a1[c] + a1[c];
+                a1[c] = a1[c] * a2 - a2;
+              }
             }
 
-            out[gid] = a1;
+            DataT result = a1[0];
+            for(int c = 1; c < Chains; ++c) {
+              result *= a1[c];
+            }
+            out[gid] = result;
           });
     }));
   }
@@ -81,18 +98,136 @@ public:
     std::stringstream name;
     name << "MicroBench_Arith_";
     name << ReadableTypename<DataT>::name << "_";
+    name << Chains << "Chains_";
+    name << Iterations;
+    return name.str();
+  }
+};
+
+template <typename DataT, int Chains, int Iterations>
+class MicroBenchDotProductKernel;
+
+/**
+ * Microbenchmark stressing small integer dot products (int8 or int16 inputs, int32 accumulation),
+ * as used e.g. in quantized inference.
+ *
+ * In every iteration, each chain multiplies its 4-element vector x by y (all ones) and
+ * accumulates dot(x, y) into its 32-bit accumulator.
+ * Every chain starts from its own input element, so the compiler cannot merge the chains.
+ */
+template <typename DataT, int Chains = 1, int Iterations = 512>
+class MicroBenchDotProduct {
+protected:
+  using VecT = s::vec<DataT, 4>;
+
+  std::vector<VecT> input;
+  BenchmarkArgs args;
+
+  PrefetchedBuffer<VecT, 1> input_buf;
+  PrefetchedBuffer<int, 1> output_buf;
+
+public:
+  // The kernel runs over a basic range
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchDotProduct(const BenchmarkArgs& _args) : args(_args) {}
+
+  void setup() {
+    input.resize(args.problem_size, VecT{1});
+
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
+    output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+    // Per iteration and chain: 4 multiplications for x * y, and 4 multiply-adds for the dot product.
+    const double OP = static_cast<double>(args.problem_size) * Iterations * Chains * (4 + 4 * 2);
+    return {OP / 1024.0 / 1024.0 / 1024.0, "GOP"};
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
+      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+
+      const std::size_t n = args.problem_size;
+
+      cgh.parallel_for<MicroBenchDotProductKernel<DataT, Chains, Iterations>>(
+          s::range<1>{args.problem_size}, [=](cl::sycl::id<1> gid) {
+            const VecT y = in[gid];
+            VecT x[Chains];
+            int acc[Chains];
+            for(int c = 0; c < Chains; ++c) {
+              x[c] = in[(gid[0] + c) % n];
+              acc[c] = 0;
+            }
+
+            for(int i = 0; i < Iterations; ++i) {
+              for(int c = 0; c < Chains; ++c) {
+                x[c] = x[c] * y;
+                acc[c] += static_cast<int>(x[c].x()) * y.x() + static_cast<int>(x[c].y()) * y.y() +
+                          static_cast<int>(x[c].z()) * y.z() + static_cast<int>(x[c].w()) * y.w();
+              }
+            }
+
+            int result = 0;
+            for(int c = 0; c < Chains; ++c) {
+              result += acc[c];
+            }
+            out[gid] = result;
+          });
+    }));
+  }
+
+  bool verify(VerificationSetting& ver) {
+    auto result = output_buf.template get_access<s::access::mode::read>();
+    for(size_t i = 0; i < args.problem_size; ++i) {
+      if(result[i] != 4 * Iterations * Chains) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "MicroBench_Arith_Dot4_";
+    name << ReadableTypename<DataT>::name << "_";
+    name << Chains << "Chains_";
     name << Iterations;
     return name.str();
   }
 };
 
+template <typename DataT>
+void runChains(BenchmarkApp& app) {
+  app.run<MicroBenchArithmetic<DataT, 1>>();
+  app.run<MicroBenchArithmetic<DataT, 2>>();
+  app.run<MicroBenchArithmetic<DataT, 4>>();
+  app.run<MicroBenchArithmetic<DataT, 8>>();
+}
+
+template <typename DataT>
+void runDotProductChains(BenchmarkApp& app) {
+  app.run<MicroBenchDotProduct<DataT, 1>>();
+  app.run<MicroBenchDotProduct<DataT, 2>>();
+  app.run<MicroBenchDotProduct<DataT, 4>>();
+  app.run<MicroBenchDotProduct<DataT, 8>>();
+}
+
 int main(int argc, char** argv) {
   BenchmarkApp app(argc, argv);
 
-  app.run<MicroBenchArithmetic<int>>();
-  app.run<MicroBenchArithmetic<float>>();
+  runChains<int>(app);
+  runChains<long long>(app);
+  runChains<float>(app);
+  if(app.deviceHasAspect(s::aspect::fp16))
+    runChains<s::half>(app);
   if(app.deviceSupportsFP64())
-    app.run<MicroBenchArithmetic<double>>();
+    runChains<double>(app);
+
+  runDotProductChains<signed char>(app);
+  runDotProductChains<short>(app);
 
   return 0;
 }
@@ -0,0 +1,204 @@
+#include "common.h"
+
+#include <iostream>
+
+namespace s = cl::sycl;
+
+// The atomic operation used to increment a counter:
+//  * FetchAdd: a single fetch_add.
+//  * CompareExchange: a compare_exchange loop, as used for operations without native atomic support.
+enum class AtomicOp { FetchAdd, CompareExchange };
+
+// Which work items share a counter:
+//  * SingleAddress: all work items of the kernel.
+//  * PerWorkGroup: the work items of one work group.
+//  * PerSubGroup: the work items of one sub group.
+//  * Distinct: no sharing, every work item has its own counter in its own cache line.
+enum class AtomicContention { SingleAddress, PerWorkGroup, PerSubGroup, Distinct };
+
+template <typename DATA_TYPE, AtomicOp Op, AtomicContention Contention, s::memory_order Order, s::memory_scope Scope>
+class MicroBenchAtomicsKernel;
+
+/* Microbenchmark measuring the throughput of atomic operations on global memory.
+ *
+ * Each of the problem_size work items increments its counter OPS_PER_ITEM times.
+ * The contention level determines how many work items share a counter, while the memory order
+ * and scope determine which guarantees the atomic operations have to provide.
+ * A work group scope is only valid if all work items sharing a counter are in the same work group.
+ */
+template <typename DATA_TYPE, AtomicOp Op, AtomicContention Contention, s::memory_order Order, s::memory_scope Scope>
+class MicroBenchAtomics {
+protected:
+  static constexpr int OPS_PER_ITEM = 16;
+  // Distinct counters are padded to separate cache lines, so that they are not falsely shared
+  static constexpr std::size_t CACHE_LINE_BYTES = 64;
+  static constexpr std::size_t COUNTER_SPACING =
+      Contention == AtomicContention::Distinct ? std::max<std::size_t>(CACHE_LINE_BYTES / sizeof(DATA_TYPE), 1) : 1;
+
+  static_assert(Contention != AtomicContention::SingleAddress || Scope != s::memory_scope::work_group,
+      "Counters shared by the entire kernel require device scope");
+
+  std::vector<DATA_TYPE> counters;
+  BenchmarkArgs args;
+
+  PrefetchedBuffer<DATA_TYPE, 1> counters_buf;
+
+public:
+  MicroBenchAtomics(const BenchmarkArgs& _args) : args(_args) {
+    assert(args.problem_size % args.local_size == 0 && "Invalid problem_size/local_size combination.");
+  }
+
+  void setup() {
+    // There are never more counters than work items
+    counters.resize(args.problem_size * COUNTER_SPACING, DATA_TYPE{0});
+    counters_buf.initialize(args.device_queue, counters.data(), s::range<1>(counters.size()));
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
+      auto counters = counters_buf.template get_access<s::access::mode::read_write>(cgh);
+
+      s::nd_range<1> ndrange{{args.problem_size}, {args.local_size}};
+
+      cgh.parallel_for<MicroBenchAtomicsKernel<DATA_TYPE, Op, Contention, Order, Scope>>(
+          ndrange, [=](s::nd_item<1> item) {
+            std::size_t counter_idx = 0;
+            if constexpr(Contention == AtomicContention::PerWorkGroup) {
+              counter_idx = item.get_group_linear_id();
+            } else if constexpr(Contention == AtomicContention::PerSubGroup) {
+              const auto sg = item.get_sub_group();
+              counter_idx = item.get_group_linear_id() * sg.get_group_range()[0] + sg.get_group_id()[0];
+            } else if constexpr(Contention == AtomicContention::Distinct) {
+              counter_idx = item.get_global_linear_id() * COUNTER_SPACING;
+            }
+
+            s::atomic_ref<DATA_TYPE, Order, Scope, s::access::address_space::global_space> counter{
+                counters[counter_idx]};
+
+            for(int i = 0; i < OPS_PER_ITEM; ++i) {
+              if constexpr(Op == AtomicOp::FetchAdd) {
+                counter.fetch_add(DATA_TYPE{1});
+              } else {
+                DATA_TYPE expected = counter.load(s::memory_order::relaxed);
+                while(!counter.compare_exchange_weak(expected, expected + DATA_TYPE{1})) {
+                }
+              }
+            }
+          });
+    })); // submit
+  }
+
+  bool verify(VerificationSetting& ver) {
+    // The increments of all work items add up to problem_size * OPS_PER_ITEM.
+    const double expected = static_cast<double>(args.problem_size) * OPS_PER_ITEM;
+
+    // Floating point counters stop being exact at 2^24 (fp32), so larger sums can not be checked.
+    if(std::is_floating_point_v<DATA_TYPE> && expected > (1 << 24))
+      return true;
+
+    auto result = counters_buf.template get_access<s::access::mode::read>();
+    double sum = 0.0;
+    for(std::size_t i = 0; i < counters.size(); ++i) {
+      sum += static_cast<double>(result[i]);
+    }
+    return sum == expected;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+    return {static_cast<double>(args.problem_size) * OPS_PER_ITEM / 1.0e6, "Mop"};
+  }
+
+  static std::string getOpName() {
+    switch(Op) {
+    case AtomicOp::FetchAdd: return "FetchAdd";
+    case AtomicOp::CompareExchange: return "CompareExchange";
+    }
+    return "";
+  }
+
+  static std::string getContentionName() {
+    switch(Contention) {
+    case AtomicContention::SingleAddress: return "SingleAddress";
+    case AtomicContention::PerWorkGroup: return "PerWorkGroup";
+    case AtomicContention::PerSubGroup: return "PerSubGroup";
+    case AtomicContention::Distinct: return "Distinct";
+    }
+    return "";
+  }
+
+  static std::string getOrderName() {
+    switch(Order) {
+    case s::memory_order::relaxed: return "relaxed";
+    case s::memory_order::acquire: return "acquire";
+    case s::memory_order::release: return "release";
+    case s::memory_order::acq_rel: return "acq_rel";
+    case s::memory_order::seq_cst: return "seq_cst";
+    }
+    return "";
+  }
+
+  static std::string getScopeName() {
+    switch(Scope) {
+    case s::memory_scope::work_item: return "work_item";
+    case s::memory_scope::sub_group: return "sub_group";
+    case s::memory_scope::work_group: return "work_group";
+    case s::memory_scope::device: return "device";
+    case s::memory_scope::system: return "system";
+    }
+    return "";
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "MicroBench_Atomics_";
+    name << ReadableTypename<DATA_TYPE>::name << "_";
+    name << getOpName() << "_";
+    name << getContentionName() << "_";
+    name << getOrderName() << "_";
+    name << getScopeName();
+    return name.str();
+  }
+};
+
+template <typename DATA_TYPE, AtomicOp Op, AtomicContention Contention>
+void runContention(BenchmarkApp& app) {
+  app.run<MicroBenchAtomics<DATA_TYPE, Op, Contention, s::memory_order::relaxed, s::memory_scope::device>>();
+  app.run<MicroBenchAtomics<DATA_TYPE, Op, Contention, s::memory_order::acq_rel, s::memory_scope::device>>();
+  app.run<MicroBenchAtomics<DATA_TYPE, Op, Contention, s::memory_order::seq_cst, s::memory_scope::device>>();
+
+  if constexpr(Contention != AtomicContention::SingleAddress) {
+    app.run<MicroBenchAtomics<DATA_TYPE, Op, Contention, s::memory_order::relaxed, s::memory_scope::work_group>>();
+    app.run<MicroBenchAtomics<DATA_TYPE, Op, Contention, s::memory_order::acq_rel, s::memory_scope::work_group>>();
+    app.run<MicroBenchAtomics<DATA_TYPE, Op, Contention, s::memory_order::seq_cst, s::memory_scope::work_group>>();
+  }
+}
+
+template <typename DATA_TYPE, AtomicOp Op>
+void runOp(BenchmarkApp& app) {
+  runContention<DATA_TYPE, Op, AtomicContention::SingleAddress>(app);
+  runContention<DATA_TYPE, Op, AtomicContention::PerWorkGroup>(app);
+  runContention<DATA_TYPE, Op, AtomicContention::PerSubGroup>(app);
+  runContention<DATA_TYPE, Op, AtomicContention::Distinct>(app);
+}
+
+template <typename DATA_TYPE>
+void runType(BenchmarkApp& app) {
+  runOp<DATA_TYPE, AtomicOp::FetchAdd>(app);
+  runOp<DATA_TYPE, AtomicOp::CompareExchange>(app);
+}
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  // Sub groups are only available in nd_range kernels
+  if(app.shouldRunNDRangeKernels()) {
+    runType<int>(app);
+
+    if(app.deviceHasAspect(s::aspect::atomic64))
+      runType<long long>(app);
+
+    runType<float>(app);
+  }
+
+  return 0;
+}
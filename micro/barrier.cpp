@@ -0,0 +1,181 @@
+#include "common.h"
+
+#include <iostream>
+
+namespace s = cl::sycl;
+
+// How the work group synchronizes between phases:
+//  * NDRange: nd_item::barrier() within a parallel_for over an nd_range.
+//  * Hierarchical: consecutive parallel_for_work_item calls within a parallel_for_work_group.
+enum class BarrierStyle { NDRange, Hierarchical };
+
+template <BarrierStyle Style>
+class MicroBenchBarrierKernel;
+
+/* Microbenchmark measuring the cost of work group barriers.
+ *
+ * The kernel runs the given number of phases, each of which is separated by a barrier.
+ * In every phase, each work item reads the value of its neighbor from local memory, increments it,
+ * and stores it for the next phase. Local memory is double buffered, so that one barrier per phase suffices.
+ * The nd_range and the hierarchical variant perform exactly the same work, so the difference in run time
+ * is the difference in the cost of synchronization.
+ */
+template <BarrierStyle Style>
+class MicroBenchBarrier {
+protected:
+  std::vector<int> input;
+  BenchmarkArgs args;
+  const int num_barriers;
+
+  PrefetchedBuffer<int, 1> input_buf;
+  PrefetchedBuffer<int, 1> output_buf;
+
+public:
+  MicroBenchBarrier(const BenchmarkArgs& _args, int _num_barriers) : args(_args), num_barriers(_num_barriers) {
+    assert(args.problem_size % args.local_size == 0 && "Invalid problem_size/local_size combination.");
+  }
+
+  void setup() {
+    input.resize(args.problem_size);
+    for(std::size_t i = 0; i < input.size(); ++i)
+      input[i] = static_cast<int>(i);
+
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
+    output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
+      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+
+      const std::size_t group_size = args.local_size;
+      const int phases = num_barriers;
+
+      // Two halves of group_size elements each, one is read and the other one written in every phase
+      s::accessor<int, 1, s::access::mode::read_write, s::access::target::local> scratch{2 * group_size, cgh};
+
+      if constexpr(Style == BarrierStyle::NDRange) {
+        s::nd_range<1> ndrange{{args.problem_size}, {args.local_size}};
+
+        cgh.parallel_for<MicroBenchBarrierKernel<Style>>(ndrange, [=](s::nd_item<1> item) {
+          const std::size_t lid = item.get_local_id(0);
+          const std::size_t neighbor = (lid + 1) % group_size;
+
+          scratch[lid] = in[item.get_global_id()];
+          for(int k = 0; k < phases; ++k) {
+            item.barrier(s::access::fence_space::local_space);
+            const std::size_t src = (k % 2) * group_size;
+            const std::size_t dst = ((k + 1) % 2) * group_size;
+            scratch[dst + lid] = scratch[src + neighbor] + 1;
+          }
+          out[item.get_global_id()] = scratch[(phases % 2) * group_size + lid];
+        });
+      } else {
+        cgh.parallel_for_work_group<MicroBenchBarrierKernel<Style>>(s::range<1>{args.problem_size / group_size},
+            s::range<1>{group_size}, [=](s::group<1> grp) {
+              grp.parallel_for_work_item([&](s::h_item<1> idx) {
+                scratch[idx.get_local_id(0)] = in[idx.get_global_id()];
+              });
+
+              for(int k = 0; k < phases; ++k) {
+                const std::size_t src = (k % 2) * group_size;
+                const std::size_t dst = ((k + 1) % 2) * group_size;
+                grp.parallel_for_work_item([&](s::h_item<1> idx) {
+                  const std::size_t lid = idx.get_local_id(0);
+                  scratch[dst + lid] = scratch[src + (lid + 1) % group_size] + 1;
+                });
+              }
+
+              grp.parallel_for_work_item([&](s::h_item<1> idx) {
+                out[idx.get_global_id()] = scratch[(phases % 2) * group_size + idx.get_local_id(0)];
+              });
+            });
+      }
+    })); // submit
+  }
+
+  bool verify(VerificationSetting& ver) {
+    // After k phases, each work item holds the initial value of the work item k positions to its right, plus k.
+    auto result = output_buf.template get_access<s::access::mode::read>();
+    const std::size_t group_size = args.local_size;
+    for(std::size_t i = 0; i < args.problem_size; ++i) {
+      const std::size_t group_begin = i - i % group_size;
+      const std::size_t src = group_begin + (i % group_size + num_barriers) % group_size;
+      if(result[i] != input[src] + num_barriers)
+        return false;
+    }
+    return true;
+  }
+
+  LatencyMetric getLatencyMetric(const BenchmarkArgs& args) const {
+    // Every work group passes num_barriers barriers
+    return {static_cast<double>(args.problem_size / args.local_size) * num_barriers, "barrier"};
+  }
+
+  static std::string getStyleName() { return Style == BarrierStyle::NDRange ? "NDRange" : "Hierarchical"; }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << "MicroBench_Barrier_";
+    name << getStyleName() << "_";
+    name << num_barriers;
+    return name.str();
+  }
+};
+
+// Runs the kernel for an increasing number of barriers per work item, and derives the cost of a
+// single barrier from the slope of a least squares fit of run time vs. number of barriers.
+// This removes the constant cost of the kernel launch and the global memory accesses.
+// When autotuning the local size, every barrier count may run with a different local size,
+// so no cost can be derived and only the individual results are emitted.
+template <BarrierStyle Style>
+void runBarrierSweep(BenchmarkApp& app) {
+  const std::vector<int> barrier_counts = {0, 1, 2, 4, 8, 16, 32, 64};
+
+  std::vector<double> counts;
+  std::vector<double> times;
+  for(int num_barriers : barrier_counts) {
+    const auto time = app.run<MicroBenchBarrier<Style>>(num_barriers);
+    if(time) {
+      counts.push_back(num_barriers);
+      times.push_back(static_cast<double>(time->count()));
+    }
+  }
+
+  if(app.getArgs().autotune_local_size)
+    return;
+
+  const double num_groups = static_cast<double>(app.getArgs().problem_size / app.getArgs().local_size);
+  std::string cost = "N/A";
+  if(counts.size() >= 2) {
+    const double n = static_cast<double>(counts.size());
+    double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+    for(std::size_t i = 0; i < counts.size(); ++i) {
+      sum_x += counts[i];
+      sum_y += times[i];
+      sum_xx += counts[i] * counts[i];
+      sum_xy += counts[i] * times[i];
+    }
+    const double slope = (n * sum_xy - sum_x * sum_y) / (n * sum_xx - sum_x * sum_x);
+    cost = std::to_string(slope / num_groups);
+  }
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark("MicroBench_Barrier_" + MicroBenchBarrier<Style>::getStyleName() + "_Cost");
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  consumer.consumeResult("local-size", std::to_string(app.getArgs().local_size));
+  consumer.consumeResult("barrier-cost", cost, "ns/barrier/work-group");
+  consumer.flush();
+}
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  if(app.shouldRunNDRangeKernels())
+    runBarrierSweep<BarrierStyle::NDRange>(app);
+
+  runBarrierSweep<BarrierStyle::Hierarchical>(app);
+
+  return 0;
+}
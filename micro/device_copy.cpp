@@ -0,0 +1,217 @@
+#include "common.h"
+
+#include <cstring>
+
+namespace s = cl::sycl;
+
+using DataT = int;
+
+// The method used to copy or initialize device memory:
+//  * HandlerCopy: handler::copy between two buffer accessors.
+//  * HandlerFill: handler::fill on a buffer accessor.
+//  * KernelCopy: a parallel_for copying between two buffer accessors.
+//  * KernelFill: a parallel_for filling a buffer accessor.
+//  * USMMemcpy: queue::memcpy between two device allocations.
+//  * USMMemset: queue::memset on a device allocation.
+//  * USMKernelCopy: a parallel_for copying between two device allocations.
+enum class DeviceCopyMethod { HandlerCopy, HandlerFill, KernelCopy, KernelFill, USMMemcpy, USMMemset, USMKernelCopy };
+
+template <DeviceCopyMethod Method>
+class MicroBenchDeviceCopyKernel;
+
+/**
+ * Microbenchmark comparing the copy and fill operations provided by the SYCL runtime
+ * to equivalent kernels, for device-to-device transfers of a given size.
+ *
+ * The throughput counts all bytes read and written, i.e. copies move twice the transfer size.
+ */
+template <DeviceCopyMethod Method>
+class MicroBenchDeviceCopy {
+protected:
+  static constexpr DataT FILL_VALUE = 33;
+  static constexpr unsigned char MEMSET_VALUE = 0x2A;
+
+  static constexpr bool isUSM = Method == DeviceCopyMethod::USMMemcpy || Method == DeviceCopyMethod::USMMemset ||
+                                Method == DeviceCopyMethod::USMKernelCopy;
+  static constexpr bool isCopy = Method == DeviceCopyMethod::HandlerCopy || Method == DeviceCopyMethod::KernelCopy ||
+                                 Method == DeviceCopyMethod::USMMemcpy || Method == DeviceCopyMethod::USMKernelCopy;
+
+  BenchmarkArgs args;
+  const std::size_t transfer_bytes;
+  const std::size_t num_elements;
+  std::vector<DataT> input;
+
+  PrefetchedBuffer<DataT, 1> src_buf;
+  PrefetchedBuffer<DataT, 1> dst_buf;
+  DataT* src_usm = nullptr;
+  DataT* dst_usm = nullptr;
+
+public:
+  // Only copy and fill operations over basic ranges are measured
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchDeviceCopy(const BenchmarkArgs& args, std::size_t transfer_bytes)
+      : args(args), transfer_bytes(transfer_bytes), num_elements(transfer_bytes / sizeof(DataT)) {}
+
+  // The USM allocations are owned by this object
+  MicroBenchDeviceCopy(const MicroBenchDeviceCopy&) = delete;
+  MicroBenchDeviceCopy& operator=(const MicroBenchDeviceCopy&) = delete;
+
+  ~MicroBenchDeviceCopy() {
+    if(src_usm)
+      s::free(src_usm, args.device_queue);
+    if(dst_usm)
+      s::free(dst_usm, args.device_queue);
+  }
+
+  void setup() {
+    input.resize(num_elements);
+    for(std::size_t i = 0; i < num_elements; ++i)
+      input[i] = static_cast<DataT>(i);
+
+    if constexpr(isUSM) {
+      src_usm = s::malloc_device<DataT>(num_elements, args.device_queue);
+      dst_usm = s::malloc_device<DataT>(num_elements, args.device_queue);
+      args.device_queue.memcpy(src_usm, input.data(), transfer_bytes);
+      args.device_queue.memset(dst_usm, 0, transfer_bytes);
+      args.device_queue.wait_and_throw();
+    } else {
+      src_buf.initialize(args.device_queue, input.data(), s::range<1>(num_elements));
+      dst_buf.initialize(args.device_queue, s::range<1>(num_elements));
+    }
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    const std::size_t n = num_elements;
+
+    if constexpr(Method == DeviceCopyMethod::USMMemcpy) {
+      events.push_back(args.device_queue.memcpy(dst_usm, src_usm, transfer_bytes));
+    } else if constexpr(Method == DeviceCopyMethod::USMMemset) {
+      events.push_back(args.device_queue.memset(dst_usm, MEMSET_VALUE, transfer_bytes));
+    } else if constexpr(Method == DeviceCopyMethod::USMKernelCopy) {
+      DataT* src = src_usm;
+      DataT* dst = dst_usm;
+      events.push_back(args.device_queue.submit([&](s::handler& cgh) {
+        cgh.parallel_for<MicroBenchDeviceCopyKernel<Method>>(
+            s::range<1>{n}, [=](s::id<1> gid) { dst[gid[0]] = src[gid[0]]; });
+      }));
+    } else {
+      events.push_back(args.device_queue.submit([&](s::handler& cgh) {
+        auto dst = dst_buf.template get_access<s::access::mode::discard_write>(cgh);
+
+        if constexpr(Method == DeviceCopyMethod::HandlerCopy) {
+          auto src = src_buf.template get_access<s::access::mode::read>(cgh);
+          cgh.copy(src, dst);
+        } else if constexpr(Method == DeviceCopyMethod::HandlerFill) {
+          cgh.fill(dst, FILL_VALUE);
+        } else if constexpr(Method == DeviceCopyMethod::KernelCopy) {
+          auto src = src_buf.template get_access<s::access::mode::read>(cgh);
+          cgh.parallel_for<MicroBenchDeviceCopyKernel<Method>>(
+              s::range<1>{n}, [=](s::id<1> gid) { dst[gid] = src[gid]; });
+        } else if constexpr(Method == DeviceCopyMethod::KernelFill) {
+          cgh.parallel_for<MicroBenchDeviceCopyKernel<Method>>(
+              s::range<1>{n}, [=](s::id<1> gid) { dst[gid] = FILL_VALUE; });
+        }
+      }));
+    }
+  }
+
+  bool verify(VerificationSetting& ver) {
+    std::vector<DataT> result(num_elements);
+    if constexpr(isUSM) {
+      args.device_queue.memcpy(result.data(), dst_usm, transfer_bytes).wait();
+    } else {
+      auto acc = dst_buf.template get_access<s::access::mode::read>();
+      for(std::size_t i = 0; i < num_elements; ++i)
+        result[i] = acc[i];
+    }
+
+    DataT memset_value;
+    std::memset(&memset_value, MEMSET_VALUE, sizeof(DataT));
+
+    for(std::size_t i = 0; i < num_elements; ++i) {
+      DataT expected = FILL_VALUE;
+      if constexpr(isCopy)
+        expected = input[i];
+      if constexpr(Method == DeviceCopyMethod::USMMemset)
+        expected = memset_value;
+      if(result[i] != expected)
+        return false;
+    }
+    return true;
+  }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) const {
+    const double accessedGiB = (isCopy ? 2 : 1) * transfer_bytes / 1024.0 / 1024.0 / 1024.0;
+    return {accessedGiB, "GiB"};
+  }
+
+  static std::string getMethodName() {
+    switch(Method) {
+    case DeviceCopyMethod::HandlerCopy: return "HandlerCopy";
+    case DeviceCopyMethod::HandlerFill: return "HandlerFill";
+    case DeviceCopyMethod::KernelCopy: return "KernelCopy";
+    case DeviceCopyMethod::KernelFill: return "KernelFill";
+    case DeviceCopyMethod::USMMemcpy: return "USMMemcpy";
+    case DeviceCopyMethod::USMMemset: return "USMMemset";
+    case DeviceCopyMethod::USMKernelCopy: return "USMKernelCopy";
+    }
+    return "";
+  }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << "MicroBench_DeviceCopy_";
+    name << getMethodName() << "_";
+    name << transfer_bytes / 1024 << "KiB";
+    return name.str();
+  }
+};
+
+// Runs one method from 4 KiB up to max_transfer_bytes and emits its bandwidth curve.
+template <DeviceCopyMethod Method>
+void runTransferSizeSweep(BenchmarkApp& app, std::size_t max_transfer_bytes) {
+  using Benchmark = MicroBenchDeviceCopy<Method>;
+
+  std::stringstream curve;
+  for(std::size_t transfer_bytes = 4 * 1024; transfer_bytes <= max_transfer_bytes; transfer_bytes *= 4) {
+    const auto time = app.run<Benchmark>(transfer_bytes);
+
+    if(!curve.str().empty())
+      curve << " ";
+    curve << transfer_bytes / 1024 << "KiB:";
+    if(time) {
+      const auto metric = Benchmark{app.getArgs(), transfer_bytes}.getThroughputMetric(app.getArgs());
+      curve << std::to_string(metric.metric / (time->count() / 1.0e9));
+    } else {
+      curve << "N/A";
+    }
+  }
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark("MicroBench_DeviceCopy_" + Benchmark::getMethodName() + "_Sweep");
+  consumer.consumeResult("bandwidth-per-size", "\"" + curve.str() + "\"", "GiB/s");
+  consumer.flush();
+}
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  // The largest transfer can be changed using --max-transfer-size=<bytes>.
+  // The problem size is not used.
+  const std::size_t max_transfer_bytes =
+      app.getArgs().cli.getOrDefault<std::size_t>("--max-transfer-size", std::size_t{256} * 1024 * 1024);
+
+  runTransferSizeSweep<DeviceCopyMethod::HandlerCopy>(app, max_transfer_bytes);
+  runTransferSizeSweep<DeviceCopyMethod::KernelCopy>(app, max_transfer_bytes);
+  runTransferSizeSweep<DeviceCopyMethod::HandlerFill>(app, max_transfer_bytes);
+  runTransferSizeSweep<DeviceCopyMethod::KernelFill>(app, max_transfer_bytes);
+
+  if(app.deviceHasAspect(s::aspect::usm_device_allocations)) {
+    runTransferSizeSweep<DeviceCopyMethod::USMMemcpy>(app, max_transfer_bytes);
+    runTransferSizeSweep<DeviceCopyMethod::USMKernelCopy>(app, max_transfer_bytes);
+    runTransferSizeSweep<DeviceCopyMethod::USMMemset>(app, max_transfer_bytes);
+  }
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+#include "common.h"
+
+#include <numeric>
+#include <random>
+
+namespace s = cl::sycl;
+
+// Number of fields of a particle, e.g. x, y, z and mass.
+constexpr std::size_t NUM_FIELDS = 4;
+// Number of particles per block of the AoSoA layout. 16 fp32 values fill an AVX-512 register.
+constexpr std::size_t AOSOA_WIDTH = 16;
+// Number of consecutive particles that stay together with the block-shuffled locality.
+constexpr std::size_t SHUFFLE_BLOCK_SIZE = 64;
+
+enum class IndirectOp { Gather, Scatter };
+
+// How the particles are stored:
+//  * AoS: array of structs, the fields of one particle are adjacent.
+//  * SoA: struct of arrays, one array per field.
+//  * AoSoA: array of structs of AOSOA_WIDTH-wide arrays.
+enum class ParticleLayout { AoS, SoA, AoSoA };
+
+// Order of the particle indices:
+//  * Sequential: the identity permutation.
+//  * BlockShuffled: blocks of SHUFFLE_BLOCK_SIZE particles in random order, sequential within a block.
+//  * Random: a random permutation.
+enum class IndexLocality { Sequential, BlockShuffled, Random };
+
+template <IndirectOp Op, ParticleLayout Layout, IndexLocality Locality>
+class MicroBenchGatherScatterKernel;
+
+/**
+ * Microbenchmark measuring the bandwidth of gather and scatter operations through an index array.
+ *
+ * Gather: work item i copies particle index[i] of the input to particle i of the output.
+ * Scatter: work item i copies particle i of the input to particle index[i] of the output.
+ * Input and output use the same layout. The index array is a permutation, so there are no conflicts.
+ * The bandwidth counts every byte of a particle and the index once, so it is the effective bandwidth
+ * as seen by the application, regardless of how many cache lines are touched.
+ */
+template <IndirectOp Op, ParticleLayout Layout, IndexLocality Locality>
+class MicroBenchGatherScatter {
+protected:
+  BenchmarkArgs args;
+  std::vector<float> input;
+  std::vector<uint32_t> indices;
+
+  PrefetchedBuffer<float, 1> input_buf;
+  PrefetchedBuffer<uint32_t, 1> index_buf;
+  PrefetchedBuffer<float, 1> output_buf;
+
+public:
+  // One particle per work item of a basic range
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchGatherScatter(const BenchmarkArgs& _args) : args(_args) {
+    assert(args.problem_size % AOSOA_WIDTH == 0 && args.problem_size % SHUFFLE_BLOCK_SIZE == 0 &&
+           "Problem size must be a multiple of the AoSoA width and the shuffle block size");
+  }
+
+  static std::size_t getOffset(std::size_t particle, std::size_t field, std::size_t num_particles) {
+    if constexpr(Layout == ParticleLayout::AoS)
+      return particle * NUM_FIELDS + field;
+    if constexpr(Layout == ParticleLayout::SoA)
+      return field * num_particles + particle;
+    if constexpr(Layout == ParticleLayout::AoSoA)
+      return (particle / AOSOA_WIDTH) * NUM_FIELDS * AOSOA_WIDTH + field * AOSOA_WIDTH + particle % AOSOA_WIDTH;
+    return 0;
+  }
+
+  static float getValue(std::size_t particle, std::size_t field) {
+    // Exactly representable in fp32
+    return static_cast<float>((particle * NUM_FIELDS + field) % (1 << 24));
+  }
+
+  void setup() {
+    const std::size_t n = args.problem_size;
+
+    input.resize(n * NUM_FIELDS);
+    for(std::size_t i = 0; i < n; ++i)
+      for(std::size_t f = 0; f < NUM_FIELDS; ++f)
+        input[getOffset(i, f, n)] = getValue(i, f);
+
+    indices.resize(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::mt19937 rng{42};
+    if constexpr(Locality == IndexLocality::BlockShuffled) {
+      std::vector<uint32_t> blocks(n / SHUFFLE_BLOCK_SIZE);
+      std::iota(blocks.begin(), blocks.end(), 0);
+      std::shuffle(blocks.begin(), blocks.end(), rng);
+      for(std::size_t i = 0; i < n; ++i)
+        indices[i] = blocks[i / SHUFFLE_BLOCK_SIZE] * SHUFFLE_BLOCK_SIZE + i % SHUFFLE_BLOCK_SIZE;
+    }
+    if constexpr(Locality == IndexLocality::Random) {
+      std::shuffle(indices.begin(), indices.end(), rng);
+    }
+
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(input.size()));
+    index_buf.initialize(args.device_queue, indices.data(), s::range<1>(n));
+    output_buf.initialize(args.device_queue, s::range<1>(input.size()));
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
+      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
+      auto index = index_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+      const std::size_t n = args.problem_size;
+
+      cgh.parallel_for<MicroBenchGatherScatterKernel<Op, Layout, Locality>>(s::range<1>{n}, [=](s::id<1> gid) {
+        const std::size_t i = gid[0];
+        const std::size_t src = Op == IndirectOp::Gather ? index[i] : i;
+        const std::size_t dst = Op == IndirectOp::Gather ? i : index[i];
+        for(std::size_t f = 0; f < NUM_FIELDS; ++f) {
+          out[getOffset(dst, f, n)] = in[getOffset(src, f, n)];
+        }
+      });
+    }));
+  }
+
+  bool verify(VerificationSetting& ver) {
+    auto result = output_buf.template get_access<s::access::mode::read>();
+    const std::size_t n = args.problem_size;
+    for(std::size_t i = 0; i < n; ++i) {
+      const std::size_t src = Op == IndirectOp::Gather ? indices[i] : i;
+      const std::size_t dst = Op == IndirectOp::Gather ? i : indices[i];
+      for(std::size_t f = 0; f < NUM_FIELDS; ++f) {
+        if(result[getOffset(dst, f, n)] != getValue(src, f))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+    // Every work item reads and writes one particle, and reads one index
+    const double bytes = static_cast<double>(args.problem_size) * (2 * NUM_FIELDS * sizeof(float) + sizeof(uint32_t));
+    return {bytes / 1024.0 / 1024.0 / 1024.0, "GiB"};
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "MicroBench_GatherScatter_";
+    name << (Op == IndirectOp::Gather ? "Gather_" : "Scatter_");
+    switch(Layout) {
+    case ParticleLayout::AoS: name << "AoS_"; break;
+    case ParticleLayout::SoA: name << "SoA_"; break;
+    case ParticleLayout::AoSoA: name << "AoSoA_"; break;
+    }
+    switch(Locality) {
+    case IndexLocality::Sequential: name << "Sequential"; break;
+    case IndexLocality::BlockShuffled: name << "BlockShuffled"; break;
+    case IndexLocality::Random: name << "Random"; break;
+    }
+    return name.str();
+  }
+};
+
+template <IndirectOp Op, ParticleLayout Layout>
+void runLocalities(BenchmarkApp& app) {
+  app.run<MicroBenchGatherScatter<Op, Layout, IndexLocality::Sequential>>();
+  app.run<MicroBenchGatherScatter<Op, Layout, IndexLocality::BlockShuffled>>();
+  app.run<MicroBenchGatherScatter<Op, Layout, IndexLocality::Random>>();
+}
+
+template <IndirectOp Op>
+void runLayouts(BenchmarkApp& app) {
+  runLocalities<Op, ParticleLayout::AoS>(app);
+  runLocalities<Op, ParticleLayout::SoA>(app);
+  runLocalities<Op, ParticleLayout::AoSoA>(app);
+}
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  runLayouts<IndirectOp::Gather>(app);
+  runLayouts<IndirectOp::Scatter>(app);
+
+  return 0;
+}
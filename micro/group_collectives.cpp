@@ -0,0 +1,225 @@
+#include "common.h"
+
+#include <iostream>
+
+namespace s = cl::sycl;
+
+// The collective operations under test:
+//  * Reduce: sum over the work group.
+//  * InclusiveScan: inclusive prefix sum over the work group.
+//  * Broadcast: value of the first work item of the work group.
+//  * Shuffle: value of the neighboring work item (local id ^ 1) within the sub group.
+enum class GroupCollective { Reduce, InclusiveScan, Broadcast, Shuffle };
+
+// How the collective is implemented:
+//  * BuiltIn: SYCL 2020 group algorithms (reduce_over_group, inclusive_scan_over_group,
+//    group_broadcast, permute_group_by_xor).
+//  * LocalMemory: the equivalent hand-written code using local memory and barriers.
+enum class CollectiveImpl { BuiltIn, LocalMemory };
+
+template <typename DATA_TYPE, GroupCollective Collective, CollectiveImpl Impl>
+class MicroBenchGroupCollectivesKernel;
+
+/* Microbenchmark comparing the built-in group and sub group collectives to local memory implementations.
+ *
+ * Every work item performs COLLECTIVES_PER_ITEM collectives on values derived from its input element.
+ * The work group size is given by the local size, so that --local=auto reports the run time
+ * for all work group sizes. The local memory reduction requires the local size to be a power of two.
+ */
+template <typename DATA_TYPE, GroupCollective Collective, CollectiveImpl Impl>
+class MicroBenchGroupCollectives {
+protected:
+  static constexpr int COLLECTIVES_PER_ITEM = 16;
+
+  std::vector<DATA_TYPE> input;
+  BenchmarkArgs args;
+
+  PrefetchedBuffer<DATA_TYPE, 1> input_buf;
+  PrefetchedBuffer<DATA_TYPE, 1> output_buf;
+
+public:
+  MicroBenchGroupCollectives(const BenchmarkArgs& _args) : args(_args) {
+    assert(args.problem_size % args.local_size == 0 && "Invalid problem_size/local_size combination.");
+    assert((args.local_size & (args.local_size - 1)) == 0 && "Local size must be a power of two.");
+  }
+
+  void setup() {
+    // Small integers keep all sums exact, even for floating point types
+    input.resize(args.problem_size);
+    for(std::size_t i = 0; i < input.size(); ++i)
+      input[i] = static_cast<DATA_TYPE>(i % 7);
+
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
+    output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
+  }
+
+  template <class LocalAccessor>
+  static DATA_TYPE collective(const s::nd_item<1>& item, const LocalAccessor& scratch, DATA_TYPE x) {
+    if constexpr(Impl == CollectiveImpl::BuiltIn) {
+      if constexpr(Collective == GroupCollective::Reduce)
+        return s::reduce_over_group(item.get_group(), x, s::plus<DATA_TYPE>{});
+      else if constexpr(Collective == GroupCollective::InclusiveScan)
+        return s::inclusive_scan_over_group(item.get_group(), x, s::plus<DATA_TYPE>{});
+      else if constexpr(Collective == GroupCollective::Broadcast)
+        return s::group_broadcast(item.get_group(), x, 0);
+      else
+        return s::permute_group_by_xor(item.get_sub_group(), x, 1);
+    } else {
+      const std::size_t lid = item.get_local_id(0);
+      const std::size_t group_size = item.get_local_range(0);
+      DATA_TYPE result;
+
+      if constexpr(Collective == GroupCollective::Reduce) {
+        scratch[lid] = x;
+        for(std::size_t i = group_size / 2; i > 0; i /= 2) {
+          item.barrier(s::access::fence_space::local_space);
+          if(lid < i)
+            scratch[lid] += scratch[lid + i];
+        }
+        item.barrier(s::access::fence_space::local_space);
+        result = scratch[0];
+      } else if constexpr(Collective == GroupCollective::InclusiveScan) {
+        // Hillis-Steele scan
+        scratch[lid] = x;
+        for(std::size_t offset = 1; offset < group_size; offset *= 2) {
+          item.barrier(s::access::fence_space::local_space);
+          const DATA_TYPE v = lid >= offset ? scratch[lid - offset] : DATA_TYPE{0};
+          item.barrier(s::access::fence_space::local_space);
+          scratch[lid] += v;
+        }
+        item.barrier(s::access::fence_space::local_space);
+        result = scratch[lid];
+      } else if constexpr(Collective == GroupCollective::Broadcast) {
+        if(lid == 0)
+          scratch[0] = x;
+        item.barrier(s::access::fence_space::local_space);
+        result = scratch[0];
+      } else {
+        scratch[lid] = x;
+        item.barrier(s::access::fence_space::local_space);
+        result = scratch[lid ^ 1];
+      }
+
+      // Protect the scratch memory from being overwritten by the next collective
+      item.barrier(s::access::fence_space::local_space);
+      return result;
+    }
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
+      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+
+      s::accessor<DATA_TYPE, 1, s::access::mode::read_write, s::access::target::local> scratch{args.local_size, cgh};
+
+      s::nd_range<1> ndrange{{args.problem_size}, {args.local_size}};
+
+      cgh.parallel_for<MicroBenchGroupCollectivesKernel<DATA_TYPE, Collective, Impl>>(
+          ndrange, [=](s::nd_item<1> item) {
+            const DATA_TYPE x = in[item.get_global_id()];
+            DATA_TYPE sum = 0;
+            for(int i = 0; i < COLLECTIVES_PER_ITEM; ++i) {
+              sum += collective(item, scratch, x + static_cast<DATA_TYPE>(i));
+            }
+            out[item.get_global_id()] = sum;
+          });
+    })); // submit
+  }
+
+  bool verify(VerificationSetting& ver) {
+    auto result = output_buf.template get_access<s::access::mode::read>();
+    const std::size_t group_size = args.local_size;
+
+    for(std::size_t group_begin = 0; group_begin < args.problem_size; group_begin += group_size) {
+      DATA_TYPE group_sum = 0;
+      for(std::size_t lid = 0; lid < group_size; ++lid)
+        group_sum += input[group_begin + lid];
+
+      DATA_TYPE prefix_sum = 0;
+      for(std::size_t lid = 0; lid < group_size; ++lid) {
+        const std::size_t gid = group_begin + lid;
+        prefix_sum += input[gid];
+
+        // Every collective is applied to x + i, so the result for iteration i is
+        // the result for x plus i times the number of contributing elements.
+        DATA_TYPE base;
+        std::size_t contributors;
+        if constexpr(Collective == GroupCollective::Reduce) {
+          base = group_sum;
+          contributors = group_size;
+        } else if constexpr(Collective == GroupCollective::InclusiveScan) {
+          base = prefix_sum;
+          contributors = lid + 1;
+        } else if constexpr(Collective == GroupCollective::Broadcast) {
+          base = input[group_begin];
+          contributors = 1;
+        } else {
+          base = input[gid ^ 1];
+          contributors = 1;
+        }
+
+        DATA_TYPE expected = 0;
+        for(int i = 0; i < COLLECTIVES_PER_ITEM; ++i)
+          expected += base + static_cast<DATA_TYPE>(i * contributors);
+
+        if(result[gid] != expected)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+    // Every work item contributes one element per collective
+    return {static_cast<double>(args.problem_size) * COLLECTIVES_PER_ITEM / 1.0e9, "Gelem"};
+  }
+
+  static std::string getCollectiveName() {
+    switch(Collective) {
+    case GroupCollective::Reduce: return "Reduce";
+    case GroupCollective::InclusiveScan: return "InclusiveScan";
+    case GroupCollective::Broadcast: return "Broadcast";
+    case GroupCollective::Shuffle: return "Shuffle";
+    }
+    return "";
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "MicroBench_GroupCollectives_";
+    name << ReadableTypename<DATA_TYPE>::name << "_";
+    name << getCollectiveName() << "_";
+    name << (Impl == CollectiveImpl::BuiltIn ? "BuiltIn" : "LocalMem");
+    return name.str();
+  }
+};
+
+template <typename DATA_TYPE, GroupCollective Collective>
+void runCollective(BenchmarkApp& app) {
+  app.run<MicroBenchGroupCollectives<DATA_TYPE, Collective, CollectiveImpl::BuiltIn>>();
+  app.run<MicroBenchGroupCollectives<DATA_TYPE, Collective, CollectiveImpl::LocalMemory>>();
+}
+
+template <typename DATA_TYPE>
+void runCollectives(BenchmarkApp& app) {
+  runCollective<DATA_TYPE, GroupCollective::Reduce>(app);
+  runCollective<DATA_TYPE, GroupCollective::InclusiveScan>(app);
+  runCollective<DATA_TYPE, GroupCollective::Broadcast>(app);
+  runCollective<DATA_TYPE, GroupCollective::Shuffle>(app);
+}
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  // Group algorithms and barriers require nd_range kernels
+  if(app.shouldRunNDRangeKernels()) {
+    runCollectives<int>(app);
+    runCollectives<float>(app);
+
+    if(app.deviceSupportsFP64())
+      runCollectives<double>(app);
+  }
+
+  return 0;
+}
@@ -1,5 +1,7 @@
 #include "common.h"
 
+#include <algorithm>
+
 namespace s = cl::sycl;
 
 // The data type to be copied. This was originally a single byte (char), however
@@ -80,6 +82,9 @@ protected:
   static constexpr DataT TEST_VALUE = 33;
 
 public:
+  // Only copy operations are measured
+  static constexpr bool usesLocalSize = false;
+
   MicroBenchHostDeviceBandwidth(const BenchmarkArgs& args)
       : args(args), copy_size(getBufferSize<Dims, false>(args.problem_size)),
         strided_buffer_size(getBufferSize<Dims, Strided>(args.problem_size)) {}
@@ -234,6 +239,167 @@ public:
   }
 };
 
+// Host memory and transfer strategy of USM transfers:
+//  * Pageable: regular host allocation, one queue::memcpy.
+//  * Pinned: host allocation using malloc_host, one queue::memcpy.
+//  * PinnedChunked: host allocation using malloc_host, split into NUM_CHUNKS independent
+//    queue::memcpy operations that are submitted back to back, so they can be pipelined.
+enum class USMTransferMode { Pageable, Pinned, PinnedChunked };
+
+/**
+ * Microbenchmark measuring host<->device bandwidth of USM transfers of a given size.
+ *
+ * The device memory is allocated using malloc_device, and copies are done using queue::memcpy.
+ * Sweeping the transfer size shows the latency of small transfers, as well as the size
+ * required to approach the peak bandwidth (see runTransferSizeSweep()).
+ * The problem size is not used.
+ */
+template <CopyDirection Direction, USMTransferMode Mode>
+class MicroBenchUSMTransfer {
+protected:
+  static constexpr std::size_t NUM_CHUNKS = 8;
+  static constexpr DataT TEST_VALUE = 33;
+
+  BenchmarkArgs args;
+  const std::size_t transfer_bytes;
+  const std::size_t num_elements;
+
+  std::vector<DataT> pageable_data;
+  DataT* host_data = nullptr;
+  DataT* device_data = nullptr;
+
+public:
+  // Only copy operations are measured
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchUSMTransfer(const BenchmarkArgs& args, std::size_t transfer_bytes)
+      : args(args), transfer_bytes(transfer_bytes), num_elements(transfer_bytes / sizeof(DataT)) {
+    assert(num_elements % NUM_CHUNKS == 0 && "Transfer size must be divisible into chunks");
+  }
+
+  // The USM allocations are owned by this object
+  MicroBenchUSMTransfer(const MicroBenchUSMTransfer&) = delete;
+  MicroBenchUSMTransfer& operator=(const MicroBenchUSMTransfer&) = delete;
+
+  ~MicroBenchUSMTransfer() {
+    if(device_data)
+      s::free(device_data, args.device_queue);
+    if(host_data && Mode != USMTransferMode::Pageable)
+      s::free(host_data, args.device_queue);
+  }
+
+  void setup() {
+    if constexpr(Mode == USMTransferMode::Pageable) {
+      pageable_data.resize(num_elements);
+      host_data = pageable_data.data();
+    } else {
+      host_data = s::malloc_host<DataT>(num_elements, args.device_queue);
+    }
+    device_data = s::malloc_device<DataT>(num_elements, args.device_queue);
+
+    if constexpr(Direction == CopyDirection::HOST_TO_DEVICE) {
+      std::fill(host_data, host_data + num_elements, TEST_VALUE);
+    } else {
+      std::fill(host_data, host_data + num_elements, DataT{0});
+      args.device_queue.fill(device_data, TEST_VALUE, num_elements);
+    }
+    args.device_queue.wait_and_throw();
+  }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) const {
+    return {transfer_bytes / 1024.0 / 1024.0 / 1024.0, "GiB"};
+  }
+
+  LatencyMetric getLatencyMetric(const BenchmarkArgs& args) const { return {1.0, "transfer"}; }
+
+  void run() {
+    DataT* dst = Direction == CopyDirection::HOST_TO_DEVICE ? device_data : host_data;
+    const DataT* src = Direction == CopyDirection::HOST_TO_DEVICE ? host_data : device_data;
+
+    if constexpr(Mode == USMTransferMode::PinnedChunked) {
+      const std::size_t chunk_elements = num_elements / NUM_CHUNKS;
+      for(std::size_t chunk = 0; chunk < NUM_CHUNKS; ++chunk) {
+        const std::size_t offset = chunk * chunk_elements;
+        args.device_queue.memcpy(dst + offset, src + offset, chunk_elements * sizeof(DataT));
+      }
+    } else {
+      args.device_queue.memcpy(dst, src, transfer_bytes);
+    }
+  }
+
+  bool verify(VerificationSetting&) {
+    if constexpr(Direction == CopyDirection::HOST_TO_DEVICE) {
+      std::vector<DataT> result(num_elements);
+      args.device_queue.memcpy(result.data(), device_data, transfer_bytes).wait();
+      return std::all_of(result.begin(), result.end(), [](DataT v) { return v == TEST_VALUE; });
+    } else {
+      return std::all_of(host_data, host_data + num_elements, [](DataT v) { return v == TEST_VALUE; });
+    }
+  }
+
+  static std::string getConfigName() {
+    std::stringstream name;
+    name << "MicroBench_HostDeviceBandwidth_USM_";
+    name << (Direction == CopyDirection::HOST_TO_DEVICE ? "H2D_" : "D2H_");
+    switch(Mode) {
+    case USMTransferMode::Pageable: name << "Pageable"; break;
+    case USMTransferMode::Pinned: name << "Pinned"; break;
+    case USMTransferMode::PinnedChunked: name << "PinnedChunked"; break;
+    }
+    return name.str();
+  }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << getConfigName() << "_" << transfer_bytes / 1024 << "KiB";
+    return name.str();
+  }
+};
+
+// Runs the transfer from 4 KiB up to max_transfer_bytes and emits the bandwidth curve,
+// the peak bandwidth and the half-bandwidth point, i.e. the smallest transfer size
+// reaching half of the peak bandwidth.
+template <CopyDirection Direction, USMTransferMode Mode>
+void runTransferSizeSweep(BenchmarkApp& app, std::size_t max_transfer_bytes) {
+  using Benchmark = MicroBenchUSMTransfer<Direction, Mode>;
+
+  std::vector<std::size_t> sizes;
+  std::vector<double> bandwidths;
+  for(std::size_t transfer_bytes = 4 * 1024; transfer_bytes <= max_transfer_bytes; transfer_bytes *= 2) {
+    const auto time = app.run<Benchmark>(transfer_bytes);
+    if(time) {
+      sizes.push_back(transfer_bytes);
+      const auto metric = Benchmark{app.getArgs(), transfer_bytes}.getThroughputMetric(app.getArgs());
+      bandwidths.push_back(metric.metric / (time->count() / 1.0e9));
+    }
+  }
+
+  const double peak = bandwidths.empty() ? 0.0 : *std::max_element(bandwidths.begin(), bandwidths.end());
+  std::string half_bandwidth_size = "N/A";
+  std::stringstream curve;
+  for(std::size_t i = 0; i < sizes.size(); ++i) {
+    if(i != 0)
+      curve << " ";
+    curve << sizes[i] / 1024 << "KiB:" << std::to_string(bandwidths[i]);
+    if(half_bandwidth_size == "N/A" && bandwidths[i] >= 0.5 * peak)
+      half_bandwidth_size = std::to_string(sizes[i] / 1024);
+  }
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark(Benchmark::getConfigName() + "_Sweep");
+  consumer.consumeResult("bandwidth-per-size", "\"" + curve.str() + "\"", "GiB/s");
+  consumer.consumeResult("peak-bandwidth", std::to_string(peak), "GiB/s");
+  consumer.consumeResult("half-bandwidth-size", half_bandwidth_size, "KiB");
+  consumer.flush();
+}
+
+template <CopyDirection Direction>
+void runTransferSizeSweeps(BenchmarkApp& app, std::size_t max_transfer_bytes) {
+  runTransferSizeSweep<Direction, USMTransferMode::Pageable>(app, max_transfer_bytes);
+  runTransferSizeSweep<Direction, USMTransferMode::Pinned>(app, max_transfer_bytes);
+  runTransferSizeSweep<Direction, USMTransferMode::PinnedChunked>(app, max_transfer_bytes);
+}
+
 int main(int argc, char** argv) {
   BenchmarkApp app(argc, argv);
 
@@ -253,5 +419,17 @@ int main(int argc, char** argv) {
   app.run<MicroBenchHostDeviceBandwidth<2, CopyDirection::DEVICE_TO_HOST, true>>();
   app.run<MicroBenchHostDeviceBandwidth<3, CopyDirection::DEVICE_TO_HOST, true>>();
 
+  // The largest transfer of the USM sweeps can be changed using --max-transfer-size=<bytes>.
+  // By default, the sweep goes up to 4 GiB or the largest allocation supported by the device.
+  const std::size_t max_alloc_bytes =
+      app.getArgs().device_queue.get_device().get_info<s::info::device::max_mem_alloc_size>();
+  const std::size_t max_transfer_bytes = app.getArgs().cli.getOrDefault<std::size_t>(
+      "--max-transfer-size", std::min(std::size_t{4} << 30, max_alloc_bytes));
+
+  if(app.deviceHasAspect(s::aspect::usm_device_allocations) && app.deviceHasAspect(s::aspect::usm_host_allocations)) {
+    runTransferSizeSweeps<CopyDirection::HOST_TO_DEVICE>(app, max_transfer_bytes);
+    runTransferSizeSweeps<CopyDirection::DEVICE_TO_HOST>(app, max_transfer_bytes);
+  }
+
   return 0;
 }
@@ -4,11 +4,47 @@
 
 namespace s = cl::sycl;
 
-template <typename DATA_TYPE, int COMP_ITERS>
+// Number of local memory banks that the access patterns are designed for.
+// This matches NVIDIA and AMD GPUs; devices with fewer banks see conflicts at smaller strides.
+constexpr int LOCAL_MEM_BANKS = 32;
+
+// Stride value that selects the broadcast pattern, where all work items read the same element.
+constexpr int BROADCAST = 0;
+
+template <typename DATA_TYPE>
+std::string getLocalMemTypeName() {
+  return ReadableTypename<DATA_TYPE>::name;
+}
+
+template <>
+std::string getLocalMemTypeName<s::int4>() {
+  return "int32x4";
+}
+
+template <typename DATA_TYPE>
+bool isInitialValue(const DATA_TYPE& v) {
+  return v == DATA_TYPE{42};
+}
+
+template <>
+bool isInitialValue<s::int4>(const s::int4& v) {
+  return v.x() == 42 && v.y() == 42 && v.z() == 42 && v.w() == 42;
+}
+
+template <typename DATA_TYPE, int COMP_ITERS, int Stride>
 class MicroBenchLocalMemoryKernel;
 
-/* Microbenchmark stressing the local memory. */
-template <typename DATA_TYPE, int COMP_ITERS>
+/* Microbenchmark stressing the local memory.
+ *
+ * Within each group of LOCAL_MEM_BANKS consecutive work items, work item i reads element i * Stride
+ * and writes the element of work item i+1. Strides are given in elements: for 32-bit elements and
+ * 4-byte banks, stride 1 (and any odd stride) is conflict-free, while a stride of LOCAL_MEM_BANKS
+ * maps all work items to the same bank (worst case). Wider elements (long long, int4) span
+ * sizeof(DATA_TYPE) / 4 banks each, so the same strides touch correspondingly more banks per work item
+ * and the labels do not carry these conflict-free/worst-case meanings for them.
+ * With BROADCAST, all work items read the same element.
+ */
+template <typename DATA_TYPE, int COMP_ITERS, int Stride = 1>
 class MicroBenchLocalMemory {
 protected:
   std::vector<DATA_TYPE> input;
@@ -24,7 +60,7 @@ public:
 
   void setup() {
     // buffers initialized to a default value
-    input.resize(args.problem_size, 42);
+    input.resize(args.problem_size, DATA_TYPE{42});
 
     input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
     output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
@@ -34,39 +70,60 @@ public:
     events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
       auto in = input_buf.template get_access<s::access::mode::read>(cgh);
       auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+
+      constexpr int slot_stride = Stride == BROADCAST ? 1 : Stride;
+      // Each row of LOCAL_MEM_BANKS work items uses LOCAL_MEM_BANKS elements, slot_stride apart.
+      // Consecutive rows are interleaved within these gaps, and once they are used up, the next rows
+      // continue in a new block of LOCAL_MEM_BANKS * slot_stride elements. Thus, rows never share elements.
+      const std::size_t num_rows = (args.local_size + LOCAL_MEM_BANKS - 1) / LOCAL_MEM_BANKS;
+      const std::size_t num_blocks = (num_rows + slot_stride - 1) / slot_stride;
+      const std::size_t local_mem_size = num_blocks * LOCAL_MEM_BANKS * slot_stride;
+
       // local memory definition
-      s::accessor<DATA_TYPE, 1, s::access::mode::read_write, s::access::target::local> local_mem(args.local_size, cgh);
+      s::accessor<DATA_TYPE, 1, s::access::mode::read_write, s::access::target::local> local_mem(local_mem_size, cgh);
 
       s::nd_range<1> ndrange{{args.problem_size}, {args.local_size}};
 
-      cgh.parallel_for<MicroBenchLocalMemoryKernel<DATA_TYPE, COMP_ITERS>>(ndrange, [=](s::nd_item<1> item) {
-        DATA_TYPE r0;
+      cgh.parallel_for<MicroBenchLocalMemoryKernel<DATA_TYPE, COMP_ITERS, Stride>>(ndrange, [=](s::nd_item<1> item) {
         int gid = item.get_global_id(0);
         int lid = item.get_local_id(0);
-        int lid2 = (item.get_local_id(0)+1) % item.get_local_range()[0];
+        int lane = lid % LOCAL_MEM_BANKS;
+        int row = lid / LOCAL_MEM_BANKS;
 
-        local_mem[lid] = in[gid];
+        int row_base = row % slot_stride + (row / slot_stride) * LOCAL_MEM_BANKS * slot_stride;
+
+        int read_idx = Stride == BROADCAST ? 0 : row_base + lane * slot_stride;
+        int write_idx = row_base + ((lane + 1) % LOCAL_MEM_BANKS) * slot_stride;
+
+        local_mem[read_idx] = in[gid];
 
         item.barrier(s::access::fence_space::local_space);
 
         // Note: this is dangerous, as a compiler could in principle be smart enough to figure out that it can just drop this
-        //       so far, we haven't encountered such a compiler, and all options to make it "safer" 
+        //       so far, we haven't encountered such a compiler, and all options to make it "safer"
         //       introduce overhead on at least some platform / data type combinations
         for(int i = 0; i < COMP_ITERS; i++) {
-          local_mem[lid2] = local_mem[lid];
+          local_mem[write_idx] = local_mem[read_idx];
         }
 
         item.barrier(s::access::fence_space::local_space);
 
-        out[gid] = local_mem[lid];
+        out[gid] = local_mem[read_idx];
       });
     })); // submit
   }
 
+  static std::string getPatternName() {
+    if(Stride == BROADCAST)
+      return "Broadcast";
+    return "Stride" + std::to_string(Stride);
+  }
+
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "MicroBench_LocalMem_";
-    name << ReadableTypename<DATA_TYPE>::name << "_";
+    name << getLocalMemTypeName<DATA_TYPE>() << "_";
+    name << getPatternName() << "_";
     name << COMP_ITERS;
     return name.str();
   }
@@ -74,7 +131,7 @@ public:
   bool verify(VerificationSetting& ver) {
     auto result = output_buf.template get_access<s::access::mode::read>();
     for(size_t i = 0; i < args.problem_size; ++i) {
-      if(result[i] != 42) {
+      if(!isInitialValue(result[i])) {
         return false;
       }
     }
@@ -82,25 +139,66 @@ public:
   }
 
   static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
-    const double throughput = (args.problem_size * sizeof(DATA_TYPE) * COMP_ITERS * 2) / 1024 / 1024 / 1024;
+    // Every iteration reads and writes one element
+    const double throughput =
+        static_cast<double>(args.problem_size) * sizeof(DATA_TYPE) * COMP_ITERS * 2 / 1024.0 / 1024.0 / 1024.0;
     return {throughput, "GiB"};
   }
 };
 
+template <typename DATA_TYPE, int COMP_ITERS, int Stride>
+void runAccessPattern(BenchmarkApp& app, std::stringstream& bandwidths, std::stringstream& local_sizes) {
+  using Benchmark = MicroBenchLocalMemory<DATA_TYPE, COMP_ITERS, Stride>;
+
+  const auto time = app.run<Benchmark>();
+  const auto local_size = app.getLastLocalSize();
+  if(!bandwidths.str().empty()) {
+    bandwidths << " ";
+    local_sizes << " ";
+  }
+  bandwidths << Benchmark::getPatternName() << ":";
+  local_sizes << Benchmark::getPatternName() << ":";
+  if(time && local_size) {
+    bandwidths << std::to_string(Benchmark::getThroughputMetric(app.getArgs()).metric / (time->count() / 1.0e9));
+    local_sizes << *local_size;
+  } else {
+    bandwidths << "N/A";
+    local_sizes << "N/A";
+  }
+}
+
+// Runs all access patterns for one data type and emits their bandwidths side by side.
+// When autotuning, every pattern reports the bandwidth of its best local size.
+template <typename DATA_TYPE, int COMP_ITERS, int... Strides>
+void runAccessPatterns(BenchmarkApp& app) {
+  std::stringstream bandwidths;
+  std::stringstream local_sizes;
+  (runAccessPattern<DATA_TYPE, COMP_ITERS, Strides>(app, bandwidths, local_sizes), ...);
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark("MicroBench_LocalMem_" + getLocalMemTypeName<DATA_TYPE>() + "_AccessPatterns");
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  if(app.getArgs().autotune_local_size)
+    consumer.consumeResult("local-size-per-pattern", "\"" + local_sizes.str() + "\"");
+  else
+    consumer.consumeResult("local-size", std::to_string(app.getArgs().local_size));
+  consumer.consumeResult("bandwidth-per-pattern", "\"" + bandwidths.str() + "\"", "GiB/s");
+  consumer.flush();
+}
+
 int main(int argc, char** argv) {
   constexpr int compute_iters = 1024 * 4;
 
   BenchmarkApp app(argc, argv);
 
-  // int
-  app.run<MicroBenchLocalMemory<int, compute_iters>>();
+  // 32 bit
+  runAccessPatterns<int, compute_iters, 1, 2, 4, 8, 16, 32, BROADCAST>(app);
 
-  // single precision
-  app.run<MicroBenchLocalMemory<float, compute_iters>>();
+  // 64 bit
+  runAccessPatterns<long long, compute_iters, 1, 2, 4, 8, 16, 32, BROADCAST>(app);
 
-  // double precision
-  if(app.deviceSupportsFP64())
-    app.run<MicroBenchLocalMemory<double, compute_iters>>();
+  // 128 bit
+  runAccessPatterns<s::int4, compute_iters, 1, 2, 4, 8, 16, 32, BROADCAST>(app);
 
   return 0;
 }
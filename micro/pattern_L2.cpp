@@ -4,29 +4,85 @@
 
 namespace s = cl::sycl;
 
-template <typename DATA_TYPE, int COMP_ITERS> class MicroBenchL2Kernel;
-
-/* Microbenchmark stressing the main arithmetic units. */
-template <typename DATA_TYPE, int COMP_ITERS>
+// How the work items of the kernel walk over the footprint:
+//  * Contiguous: in each iteration, neighboring work items read neighboring elements.
+//  * Strided: as contiguous, but neighboring work items are STRIDE elements apart.
+//  * Blocked: each work item reads a contiguous block of elements on its own.
+enum class L2AccessPattern { Contiguous, Strided, Blocked };
+
+template <typename DATA_TYPE, L2AccessPattern Pattern>
+class MicroBenchL2Kernel;
+
+/* Microbenchmark measuring the bandwidth of the cache hierarchy.
+ *
+ * Every one of the problem_size work items performs at least READS_PER_ITEM reads from a buffer
+ * with the given footprint, which is varied independently of the number of work items.
+ * For large footprints, the number of reads per work item is raised such that the whole footprint
+ * is read, instead of only the part covered by problem_size * READS_PER_ITEM reads.
+ * Sweeping the footprint yields a bandwidth vs. working set curve, with a knee
+ * wherever the footprint exceeds the capacity of a cache level.
+ *
+ * Footprints have to be powers of two, so that indices can be wrapped with a mask.
+ * The throughput only counts the bytes that were actually requested by the kernel, i.e.
+ * the strided pattern reports less bandwidth when the stride wastes parts of cache lines.
+ */
+template <typename DATA_TYPE, L2AccessPattern Pattern>
 class MicroBenchL2
 {
 protected:
-    std::vector<DATA_TYPE> input;
-    BenchmarkArgs args;
-
-    PrefetchedBuffer<DATA_TYPE, 1> input_buf;
-    PrefetchedBuffer<DATA_TYPE, 1> output_buf;
+  static constexpr int READS_PER_ITEM = 64;
+  // 64 bytes for fp32, i.e. one element per cache line on most CPUs
+  static constexpr std::size_t STRIDE = 16;
+
+  std::vector<DATA_TYPE> input;
+  BenchmarkArgs args;
+  const std::size_t footprint_bytes;
+  const std::size_t num_elements;
+  const std::size_t reads_per_item;
+
+  PrefetchedBuffer<DATA_TYPE, 1> input_buf;
+  PrefetchedBuffer<DATA_TYPE, 1> output_buf;
 public:
-  MicroBenchL2(const BenchmarkArgs &_args) : args(_args) {}
+  // The footprint sweep runs over a basic range
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchL2(const BenchmarkArgs &_args, std::size_t _footprint_bytes)
+      : args(_args), footprint_bytes(_footprint_bytes), num_elements(_footprint_bytes / sizeof(DATA_TYPE)),
+        reads_per_item(getReadsPerItem(_args.problem_size, num_elements)) {
+    assert(num_elements > 0 && (num_elements & (num_elements - 1)) == 0 && "Footprint must be a power of two");
+  }
+
+  // Enough reads per work item such that every element (every STRIDE-th one for Strided) of the footprint is read
+  static std::size_t getReadsPerItem(std::size_t num_items, std::size_t num_elements) {
+    const std::size_t num_read_elements =
+        Pattern == L2AccessPattern::Strided ? std::max<std::size_t>(num_elements / STRIDE, 1) : num_elements;
+    return std::max<std::size_t>(READS_PER_ITEM, (num_read_elements + num_items - 1) / num_items);
+  }
 
   void setup() {
-    // buffers initialized to a default value 
-    input. resize(args.problem_size, 10);
+    // buffers initialized to a default value
+    input.resize(num_elements, 1);
 
-    input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(num_elements));
     output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
   }
 
+  static std::size_t getReadIndex(std::size_t gid, std::size_t num_items, std::size_t reads_per_item, std::size_t i) {
+    if constexpr(Pattern == L2AccessPattern::Contiguous)
+      return gid + i * num_items;
+    if constexpr(Pattern == L2AccessPattern::Strided)
+      return (gid + i * num_items) * STRIDE;
+    if constexpr(Pattern == L2AccessPattern::Blocked)
+      return gid * reads_per_item + i;
+    return 0;
+  }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) const {
+    const double readGiB =
+        static_cast<double>(args.problem_size) * reads_per_item * sizeof(DATA_TYPE) / 1024.0 / 1024.0 / 1024.0;
+    return {readGiB, "GiB"};
+  }
+
   void run(std::vector<cl::sycl::event>& events){
 
     events.push_back(args.device_queue.submit(
@@ -34,58 +90,128 @@ public:
       auto in  =  input_buf.template get_access<s::access::mode::read>(cgh);
       auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
       cl::sycl::range<1> ndrange {args.problem_size};
+      const std::size_t num_items = args.problem_size;
+      const std::size_t mask = num_elements - 1;
+      const std::size_t num_reads = reads_per_item;
 
-      cgh.parallel_for<MicroBenchL2Kernel<DATA_TYPE,COMP_ITERS>>(ndrange,
+      cgh.parallel_for<MicroBenchL2Kernel<DATA_TYPE, Pattern>>(ndrange,
         [=](cl::sycl::id<1> gid)
       {
-        DATA_TYPE r0;
-        for (int i=0;i<COMP_ITERS;i++) {
-            r0 = in[gid];
-            out[gid] = r0; 
+        DATA_TYPE r0 = 0;
+        for (std::size_t i = 0; i < num_reads; i++) {
+          r0 += in[getReadIndex(gid[0], num_items, num_reads, i) & mask];
         }
         out[gid] = r0;
       });
     })); // submit
   }
 
-  static std::string getBenchmarkName() {
+  bool verify(VerificationSetting &ver) {
+    auto result = output_buf.template get_access<s::access::mode::read>();
+    for(size_t i = 0; i < args.problem_size; ++i) {
+      if(result[i] != static_cast<DATA_TYPE>(reads_per_item)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static std::string getPatternName() {
+    switch(Pattern) {
+    case L2AccessPattern::Contiguous: return "Contiguous";
+    case L2AccessPattern::Strided: return "Strided";
+    case L2AccessPattern::Blocked: return "Blocked";
+    }
+    return "";
+  }
+
+  std::string getBenchmarkName() const {
     std::stringstream name;
     name << "MicroBench_L2_";
+    name << getPatternName() << "_";
     name << ReadableTypename<DATA_TYPE>::name << "_";
-    name << COMP_ITERS;
+    name << footprint_bytes / 1024 << "KiB";
     return name.str();
   }
 };
 
-int main(int argc, char** argv)
+// Runs the footprint sweep for one access pattern and data type, and infers the cache capacities
+// from the resulting bandwidth curve: A knee is reported at the last footprint before the bandwidth
+// drops below KNEE_THRESHOLD times the bandwidth of the current plateau.
+template <typename DATA_TYPE, L2AccessPattern Pattern>
+void runFootprintSweep(BenchmarkApp& app, std::size_t max_footprint)
 {
-  BenchmarkApp app(argc, argv);
+  constexpr double KNEE_THRESHOLD = 0.75;
+  constexpr std::size_t MAX_KNEES = 3;
+
+  std::vector<std::size_t> footprints;
+  std::vector<double> bandwidths;
+  for(std::size_t footprint = 4 * 1024; footprint <= max_footprint; footprint *= 2) {
+    const auto time = app.run<MicroBenchL2<DATA_TYPE, Pattern>>(footprint);
+    if(time) {
+      const auto metric = MicroBenchL2<DATA_TYPE, Pattern>{app.getArgs(), footprint}.getThroughputMetric(app.getArgs());
+      footprints.push_back(footprint);
+      bandwidths.push_back(metric.metric / (time->count() / 1.0e9));
+    }
+  }
 
-  // int
-  app.run< MicroBenchL2<int,1> >();
-  app.run< MicroBenchL2<int,2> >();
-  app.run< MicroBenchL2<int,4> >();
-  app.run< MicroBenchL2<int,8> >();
-  app.run< MicroBenchL2<int,16> >();
+  std::vector<std::size_t> knees;
+  double plateau = bandwidths.empty() ? 0.0 : bandwidths[0];
+  for(std::size_t i = 1; i < bandwidths.size() && knees.size() < MAX_KNEES; ++i) {
+    if(bandwidths[i] < KNEE_THRESHOLD * plateau) {
+      knees.push_back(footprints[i - 1]);
+      plateau = bandwidths[i];
+    } else {
+      plateau = std::max(plateau, bandwidths[i]);
+    }
+  }
 
-  // single precision  
-  app.run< MicroBenchL2<float,1> >();
-  app.run< MicroBenchL2<float,2> >();
-  app.run< MicroBenchL2<float,4> >();
-  app.run< MicroBenchL2<float,8> >();
-  app.run< MicroBenchL2<float,16> >();
+  std::stringstream curve;
+  for(std::size_t i = 0; i < footprints.size(); ++i) {
+    if(i != 0)
+      curve << " ";
+    curve << footprints[i] / 1024 << "KiB:" << std::to_string(bandwidths[i]);
+  }
 
-  // double precision
-  if(app.deviceSupportsFP64()) {
-    app.run<MicroBenchL2<double, 1>>();
-    app.run<MicroBenchL2<double, 2>>();
-    app.run<MicroBenchL2<double, 4>>();
-    app.run<MicroBenchL2<double, 8>>();
-    app.run<MicroBenchL2<double, 16>>();
+  auto& consumer = *app.getArgs().result_consumer;
+  std::stringstream name;
+  name << "MicroBench_L2_" << MicroBenchL2<DATA_TYPE, Pattern>::getPatternName() << "_"
+       << ReadableTypename<DATA_TYPE>::name << "_CacheKnees";
+  consumer.proceedToBenchmark(name.str());
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  consumer.consumeResult("bandwidth-per-footprint", "\"" + curve.str() + "\"", "GiB/s");
+  for(std::size_t level = 0; level < MAX_KNEES; ++level) {
+    const std::string result_name = "cache-knee-" + std::to_string(level + 1);
+    if(level < knees.size())
+      consumer.consumeResult(result_name, std::to_string(knees[level] / 1024), "KiB");
+    else
+      consumer.consumeResult(result_name, "N/A");
   }
+  consumer.flush();
+}
 
-  return 0;
+template <typename DATA_TYPE>
+void runFootprintSweeps(BenchmarkApp& app, std::size_t max_footprint)
+{
+  runFootprintSweep<DATA_TYPE, L2AccessPattern::Contiguous>(app, max_footprint);
+  runFootprintSweep<DATA_TYPE, L2AccessPattern::Strided>(app, max_footprint);
+  runFootprintSweep<DATA_TYPE, L2AccessPattern::Blocked>(app, max_footprint);
 }
 
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
 
+  // The largest footprint of the sweep can be changed using --max-working-set=<bytes>.
+  const std::size_t max_footprint =
+      app.getArgs().cli.getOrDefault<std::size_t>("--max-working-set", std::size_t{256} * 1024 * 1024);
 
+  // single precision
+  runFootprintSweeps<float>(app, max_footprint);
+
+  // double precision
+  if(app.deviceSupportsFP64())
+    runFootprintSweeps<double>(app, max_footprint);
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include "common.h"
+
+#include <iomanip>
+
+namespace s = cl::sycl;
+
+template <typename DataT>
+class MicroBenchPatternMixKernel;
+
+/**
+ * Microbenchmark with a tunable ratio of arithmetic to memory accesses.
+ *
+ * Every work item reads one element, performs 2 * fma_pairs multiply-adds on it and writes it back
+ * to a second buffer. The arithmetic intensity is therefore 4 * fma_pairs FLOP per 2 * sizeof(DataT) bytes,
+ * ranging from pure streaming (no arithmetic) to compute bound.
+ * Sweeping it traces the empirical roofline of the device (see runIntensitySweep()).
+ */
+template <typename DataT>
+class MicroBenchPatternMix {
+protected:
+  std::vector<DataT> input;
+  BenchmarkArgs args;
+  const int fma_pairs;
+
+  PrefetchedBuffer<DataT, 1> input_buf;
+  PrefetchedBuffer<DataT, 1> output_buf;
+
+public:
+  // The kernel runs over a basic range
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchPatternMix(const BenchmarkArgs& _args, int _fma_pairs) : args(_args), fma_pairs(_fma_pairs) {}
+
+  void setup() {
+    input.resize(args.problem_size, DataT{1});
+
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
+    output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
+  }
+
+  double getFLOP() const { return static_cast<double>(args.problem_size) * fma_pairs * 2 * 2; }
+
+  double getBytes() const { return static_cast<double>(args.problem_size) * 2 * sizeof(DataT); }
+
+  double getArithmeticIntensity() const { return getFLOP() / getBytes(); }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) const {
+    return {getBytes() / 1024.0 / 1024.0 / 1024.0, "GiB"};
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](cl::sycl::handler& cgh) {
+      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+      const int num_pairs = fma_pairs;
+
+      cgh.parallel_for<MicroBenchPatternMixKernel<DataT>>(s::range<1>{args.problem_size}, [=](s::id<1> gid) {
+        DataT a1 = in[gid];
+        const DataT a2 = a1;
+        for(int i = 0; i < num_pairs; ++i) {
+          // We do two operations to ensure the value remains 1 and doesn't grow indefinitely.
+          a1 = a1 * a1 + a1;
+          a1 = a1 * a2 - a2;
+        }
+        out[gid] = a1;
+      });
+    }));
+  }
+
+  bool verify(VerificationSetting& ver) {
+    auto result = output_buf.template get_access<s::access::mode::read>();
+    for(size_t i = 0; i < args.problem_size; ++i) {
+      if(result[i] != DataT{1}) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << "MicroBench_PatternMix_";
+    name << ReadableTypename<DataT>::name << "_";
+    name << fma_pairs * 2 << "FMA";
+    return name.str();
+  }
+};
+
+// Runs the kernel from pure streaming up to 2 * max_fma_pairs multiply-adds per element,
+// and emits the achieved GFLOP/s and GiB/s for every arithmetic intensity (FLOP/byte).
+template <typename DataT>
+void runIntensitySweep(BenchmarkApp& app, int max_fma_pairs) {
+  std::stringstream flops;
+  std::stringstream bandwidths;
+
+  for(int fma_pairs = 0; fma_pairs <= max_fma_pairs; fma_pairs = fma_pairs == 0 ? 1 : fma_pairs * 2) {
+    const auto time = app.run<MicroBenchPatternMix<DataT>>(fma_pairs);
+    if(!time)
+      continue;
+
+    const MicroBenchPatternMix<DataT> benchmark{app.getArgs(), fma_pairs};
+    const double seconds = time->count() / 1.0e9;
+
+    if(!flops.str().empty()) {
+      flops << " ";
+      bandwidths << " ";
+    }
+    std::stringstream intensity;
+    intensity << std::setprecision(4) << benchmark.getArithmeticIntensity();
+    flops << intensity.str() << ":" << std::to_string(benchmark.getFLOP() / 1024.0 / 1024.0 / 1024.0 / seconds);
+    bandwidths << intensity.str() << ":" << std::to_string(benchmark.getBytes() / 1024.0 / 1024.0 / 1024.0 / seconds);
+  }
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark(std::string{"MicroBench_PatternMix_"} + ReadableTypename<DataT>::name + "_Roofline");
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  consumer.consumeResult("gflops-per-intensity", "\"" + flops.str() + "\"", "GFLOP/s");
+  consumer.consumeResult("bandwidth-per-intensity", "\"" + bandwidths.str() + "\"", "GiB/s");
+  consumer.flush();
+}
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  // The largest number of multiply-add pairs per element can be changed using --max-fma-pairs=<N>.
+  const int max_fma_pairs = app.getArgs().cli.getOrDefault<int>("--max-fma-pairs", 512);
+
+  runIntensitySweep<float>(app, max_fma_pairs);
+  if(app.deviceSupportsFP64())
+    runIntensitySweep<double>(app, max_fma_pairs);
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "common.h"
+
+#include <numeric>
+#include <random>
+
+namespace s = cl::sycl;
+
+// Index type of the pointer chain. 32 bit indices are sufficient for working sets of up to 16 GiB.
+using IndexT = uint32_t;
+
+// Every node of the chain occupies its own cache line (assuming 64 byte lines),
+// such that each load of the chain touches a new line.
+constexpr std::size_t NODE_STRIDE = 64 / sizeof(IndexT);
+
+class MicroBenchPointerChaseKernel;
+
+/**
+ * Microbenchmark measuring memory latency by walking a randomized cyclic pointer chain.
+ *
+ * The chain is built over a working set of the given size, with one node per cache line.
+ * The order of the nodes is a random cyclic permutation (Sattolo's algorithm), which
+ * defeats hardware prefetchers. As every load depends on the result of the previous one,
+ * the run time divided by the number of loads yields the average load latency for this working set.
+ *
+ * The number of dependent loads is given by the problem size.
+ */
+class MicroBenchPointerChase {
+protected:
+  BenchmarkArgs args;
+  const std::size_t working_set_bytes;
+  const std::size_t num_nodes;
+  std::vector<IndexT> chain;
+
+  PrefetchedBuffer<IndexT, 1> chain_buf;
+  PrefetchedBuffer<IndexT, 1> output_buf;
+
+public:
+  // A single work item chases the pointers
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchPointerChase(const BenchmarkArgs& args, std::size_t working_set_bytes)
+      : args(args), working_set_bytes(working_set_bytes),
+        num_nodes(std::max<std::size_t>(working_set_bytes / (NODE_STRIDE * sizeof(IndexT)), 1)) {}
+
+  void setup() {
+    std::vector<IndexT> order(num_nodes);
+    std::iota(order.begin(), order.end(), 0);
+
+    // Sattolo's algorithm yields a random permutation consisting of a single cycle,
+    // so the walk visits all nodes before returning to the first one.
+    std::mt19937 rng{42};
+    for(std::size_t i = num_nodes - 1; i > 0; --i) {
+      std::uniform_int_distribution<std::size_t> dist{0, i - 1};
+      std::swap(order[i], order[dist(rng)]);
+    }
+
+    chain.assign(num_nodes * NODE_STRIDE, 0);
+    for(std::size_t i = 0; i < num_nodes; ++i) {
+      chain[order[i] * NODE_STRIDE] = static_cast<IndexT>(order[(i + 1) % num_nodes] * NODE_STRIDE);
+    }
+
+    chain_buf.initialize(args.device_queue, chain.data(), s::range<1>(chain.size()));
+    output_buf.initialize(args.device_queue, s::range<1>(1));
+  }
+
+  LatencyMetric getLatencyMetric(const BenchmarkArgs& args) const {
+    return {static_cast<double>(args.problem_size), "load"};
+  }
+
+  void run(std::vector<s::event>& events) {
+    events.push_back(args.device_queue.submit([&](s::handler& cgh) {
+      auto next = chain_buf.get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.get_access<s::access::mode::discard_write>(cgh);
+      const std::size_t num_loads = args.problem_size;
+
+      cgh.single_task<MicroBenchPointerChaseKernel>([=]() {
+        IndexT current = 0;
+        for(std::size_t i = 0; i < num_loads; ++i) {
+          current = next[current];
+        }
+        // Storing the final position ensures that the walk cannot be optimized away.
+        out[0] = current;
+      });
+    }));
+  }
+
+  bool verify(VerificationSetting& ver) {
+    IndexT expected = 0;
+    for(std::size_t i = 0; i < args.problem_size; ++i) {
+      expected = chain[expected];
+    }
+    auto result = output_buf.get_access<s::access::mode::read>();
+    return result[0] == expected;
+  }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << "MicroBench_PointerChase_";
+    name << working_set_bytes / 1024 << "KiB";
+    return name.str();
+  }
+};
+
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+
+  // Sweep the working set from a size that fits into any L1 cache up to well beyond the last level cache.
+  // The upper bound can be changed using --max-working-set=<bytes>.
+  const std::size_t max_working_set =
+      app.getArgs().cli.getOrDefault<std::size_t>("--max-working-set", std::size_t{512} * 1024 * 1024);
+
+  for(std::size_t working_set = 4 * 1024; working_set <= max_working_set; working_set *= 2) {
+    app.run<MicroBenchPointerChase>(working_set);
+  }
+
+  return 0;
+}
@@ -1,5 +1,9 @@
 #include "common.h"
 
+#include <cmath>
+#include <limits>
+#include <optional>
+
 namespace s = cl::sycl;
 
 template <typename DataT, int N>
@@ -18,6 +22,9 @@ protected:
   PrefetchedBuffer<DataT, 1> output_buf;
 
 public:
+  // The kernel runs over a basic range
+  static constexpr bool usesLocalSize = false;
+
   MicroBenchSpecialFunc(const BenchmarkArgs& args) : args(args) {}
 
   void setup() {
@@ -81,6 +88,276 @@ public:
   }
 };
 
+enum class SpecialFunc { Exp, Log, Sin, Cos, Tan, Rsqrt, Sqrt, Pow, Erf };
+
+// Largest error in ULP observed by the accuracy pass of a MicroBenchSpecialFuncSingle run.
+struct SpecialFuncAccuracy {
+  std::optional<double> max_ulp;
+};
+
+template <typename DataT, SpecialFunc Func, bool Native>
+class MicroBenchSpecialFuncSingleKernel;
+
+template <typename DataT, SpecialFunc Func, bool Native>
+class MicroBenchSpecialFuncAccuracyKernel;
+
+/**
+ * Microbenchmark measuring the throughput and accuracy of a single special function,
+ * either the precise builtin or its native:: counterpart.
+ *
+ * Each work item evaluates the function for Iterations independent arguments in [0.5, 1.5),
+ * which is in the domain of all functions and below the pole of tan at pi/2.
+ * An untimed pass during setup evaluates all NUM_BASE_ARGS * Iterations distinct arguments on the device,
+ * compares them against the host libm (evaluated in long double) and records the maximum error in ULP,
+ * regardless of whether verification is enabled.
+ * Precise functions pass verification if they are within the largest error bound of the OpenCL C specification
+ * for these functions (16 ULP), native functions only need to be within a relative error of 2^-10.
+ * As log has a zero at 1, where the relative error is unbounded, native_log is checked against
+ * an absolute error of 2^-21 instead.
+ */
+template <typename DataT, SpecialFunc Func, bool Native, int Iterations = 16>
+class MicroBenchSpecialFuncSingle {
+protected:
+  static constexpr std::size_t NUM_BASE_ARGS = 1024;
+  static constexpr DataT ARG_BEGIN = 0.5;
+  static constexpr DataT ARG_STEP = 0.5 / NUM_BASE_ARGS;
+  static constexpr DataT ITERATION_STEP = 0.5 / Iterations;
+  static constexpr DataT POW_EXPONENT = 1.5;
+
+  static_assert(!Native || std::is_same_v<DataT, float>, "native:: functions are only available for fp32");
+  static_assert(!Native || Func != SpecialFunc::Erf, "There is no native::erf");
+
+  std::vector<DataT> input;
+  BenchmarkArgs args;
+  SpecialFuncAccuracy& accuracy;
+
+  PrefetchedBuffer<DataT, 1> input_buf;
+  PrefetchedBuffer<DataT, 1> output_buf;
+
+  double max_ulp = 0.0;
+  double max_rel_error = 0.0;
+  double max_abs_error = 0.0;
+
+public:
+  // The kernels run over basic ranges
+  static constexpr bool usesLocalSize = false;
+
+  MicroBenchSpecialFuncSingle(const BenchmarkArgs& args, SpecialFuncAccuracy& accuracy)
+      : args(args), accuracy(accuracy) {}
+
+  void setup() {
+    input.resize(args.problem_size);
+    for(std::size_t i = 0; i < input.size(); ++i)
+      input[i] = ARG_BEGIN + static_cast<DataT>(i % NUM_BASE_ARGS) * ARG_STEP;
+
+    input_buf.initialize(args.device_queue, input.data(), s::range<1>(args.problem_size));
+    output_buf.initialize(args.device_queue, s::range<1>(args.problem_size));
+
+    measure_accuracy();
+  }
+
+  // Evaluates every distinct argument of the benchmark kernel once on the device.
+  void measure_accuracy() {
+    std::vector<DataT> arguments(NUM_BASE_ARGS * Iterations);
+    for(std::size_t i = 0; i < NUM_BASE_ARGS; ++i) {
+      const DataT x = ARG_BEGIN + static_cast<DataT>(i) * ARG_STEP;
+      for(int j = 0; j < Iterations; ++j)
+        arguments[i * Iterations + j] = x + static_cast<DataT>(j) * ITERATION_STEP;
+    }
+
+    s::buffer<DataT, 1> arguments_buf{arguments.data(), s::range<1>(arguments.size())};
+    s::buffer<DataT, 1> results_buf{s::range<1>(arguments.size())};
+    args.device_queue.submit([&](s::handler& cgh) {
+      auto in = arguments_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = results_buf.template get_access<s::access::mode::discard_write>(cgh);
+      cgh.parallel_for<MicroBenchSpecialFuncAccuracyKernel<DataT, Func, Native>>(
+          s::range<1>{arguments.size()}, [=](s::id<1> gid) { out[gid] = apply(in[gid]); });
+    });
+
+    auto results = results_buf.template get_access<s::access::mode::read>();
+    max_ulp = 0.0;
+    max_rel_error = 0.0;
+    max_abs_error = 0.0;
+    for(std::size_t i = 0; i < arguments.size(); ++i) {
+      const long double expected = reference(arguments[i]);
+      const long double abs_error = std::abs(results[i] - expected);
+      const DataT rounded = static_cast<DataT>(expected);
+      const DataT ulp = std::nextafter(std::abs(rounded), std::numeric_limits<DataT>::infinity()) - std::abs(rounded);
+      max_ulp = std::max(max_ulp, static_cast<double>(abs_error / ulp));
+      max_abs_error = std::max(max_abs_error, static_cast<double>(abs_error));
+      // The relative error is meaningless where the function is zero (log(1))
+      if(std::abs(rounded) >= std::numeric_limits<DataT>::min())
+        max_rel_error = std::max(max_rel_error, static_cast<double>(abs_error / std::abs(expected)));
+    }
+    accuracy.max_ulp = max_ulp;
+  }
+
+  static DataT apply(DataT x) {
+    if constexpr(Native) {
+      switch(Func) {
+      case SpecialFunc::Exp: return s::native::exp(x);
+      case SpecialFunc::Log: return s::native::log(x);
+      case SpecialFunc::Sin: return s::native::sin(x);
+      case SpecialFunc::Cos: return s::native::cos(x);
+      case SpecialFunc::Tan: return s::native::tan(x);
+      case SpecialFunc::Rsqrt: return s::native::rsqrt(x);
+      case SpecialFunc::Sqrt: return s::native::sqrt(x);
+      case SpecialFunc::Pow: return s::native::powr(x, POW_EXPONENT);
+      default: return x;
+      }
+    } else {
+      switch(Func) {
+      case SpecialFunc::Exp: return s::exp(x);
+      case SpecialFunc::Log: return s::log(x);
+      case SpecialFunc::Sin: return s::sin(x);
+      case SpecialFunc::Cos: return s::cos(x);
+      case SpecialFunc::Tan: return s::tan(x);
+      case SpecialFunc::Rsqrt: return s::rsqrt(x);
+      case SpecialFunc::Sqrt: return s::sqrt(x);
+      case SpecialFunc::Pow: return s::pow(x, POW_EXPONENT);
+      case SpecialFunc::Erf: return s::erf(x);
+      }
+    }
+    return x;
+  }
+
+  static long double reference(long double x) {
+    switch(Func) {
+    case SpecialFunc::Exp: return std::exp(x);
+    case SpecialFunc::Log: return std::log(x);
+    case SpecialFunc::Sin: return std::sin(x);
+    case SpecialFunc::Cos: return std::cos(x);
+    case SpecialFunc::Tan: return std::tan(x);
+    case SpecialFunc::Rsqrt: return 1.0L / std::sqrt(x);
+    case SpecialFunc::Sqrt: return std::sqrt(x);
+    case SpecialFunc::Pow: return std::pow(x, static_cast<long double>(POW_EXPONENT));
+    case SpecialFunc::Erf: return std::erf(x);
+    }
+    return x;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+    const double OP = static_cast<double>(args.problem_size) * Iterations;
+    return {OP / 1024.0 / 1024.0 / 1024.0, "GOP"};
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(args.device_queue.submit([&](s::handler& cgh) {
+      auto in = input_buf.template get_access<s::access::mode::read>(cgh);
+      auto out = output_buf.template get_access<s::access::mode::discard_write>(cgh);
+
+      cgh.parallel_for<MicroBenchSpecialFuncSingleKernel<DataT, Func, Native>>(
+          s::range<1>{args.problem_size}, [=](s::id<1> gid) {
+            const DataT x = in[gid];
+            DataT sum = apply(x);
+            for(int i = 1; i < Iterations; ++i) {
+              sum += apply(x + static_cast<DataT>(i) * ITERATION_STEP);
+            }
+            out[gid] = sum;
+          });
+    }));
+  }
+
+  bool verify(VerificationSetting& ver) {
+    auto result = output_buf.template get_access<s::access::mode::read>();
+
+    // The accuracy of the individual results was measured during setup
+    for(std::size_t i = 0; i < args.problem_size; ++i) {
+      if(!std::isfinite(result[i]))
+        return false;
+    }
+
+    if constexpr(Native && Func == SpecialFunc::Log)
+      return max_abs_error < std::ldexp(1.0, -21);
+    else if constexpr(Native)
+      return max_rel_error < 1.0 / 1024;
+    else
+      return max_ulp <= 16.0;
+  }
+
+  static std::string getFuncName() {
+    std::string name = Native ? "native_" : "";
+    switch(Func) {
+    case SpecialFunc::Exp: return name + "exp";
+    case SpecialFunc::Log: return name + "log";
+    case SpecialFunc::Sin: return name + "sin";
+    case SpecialFunc::Cos: return name + "cos";
+    case SpecialFunc::Tan: return name + "tan";
+    case SpecialFunc::Rsqrt: return name + "rsqrt";
+    case SpecialFunc::Sqrt: return name + "sqrt";
+    case SpecialFunc::Pow: return name + (Native ? "powr" : "pow");
+    case SpecialFunc::Erf: return name + "erf";
+    }
+    return name;
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "MicroBench_sf_";
+    name << ReadableTypename<DataT>::name << "_";
+    name << getFuncName() << "_";
+    name << Iterations;
+    return name.str();
+  }
+};
+
+// Collects the throughput and accuracy of the individual functions of one data type into a table.
+template <typename DataT>
+class SpecialFuncTable {
+  BenchmarkApp& app;
+  std::stringstream throughputs;
+  std::stringstream max_ulps;
+
+public:
+  SpecialFuncTable(BenchmarkApp& app) : app(app) {}
+
+  template <SpecialFunc Func, bool Native>
+  void run() {
+    using Benchmark = MicroBenchSpecialFuncSingle<DataT, Func, Native>;
+
+    SpecialFuncAccuracy accuracy;
+    const auto time = app.run<Benchmark>(accuracy);
+
+    if(!throughputs.str().empty()) {
+      throughputs << " ";
+      max_ulps << " ";
+    }
+    throughputs << Benchmark::getFuncName() << ":";
+    max_ulps << Benchmark::getFuncName() << ":";
+    if(time)
+      throughputs << std::to_string(Benchmark::getThroughputMetric(app.getArgs()).metric / (time->count() / 1.0e9));
+    else
+      throughputs << "N/A";
+    if(accuracy.max_ulp)
+      max_ulps << std::to_string(*accuracy.max_ulp);
+    else
+      max_ulps << "N/A";
+  }
+
+  template <bool Native>
+  void runAll() {
+    run<SpecialFunc::Exp, Native>();
+    run<SpecialFunc::Log, Native>();
+    run<SpecialFunc::Sin, Native>();
+    run<SpecialFunc::Cos, Native>();
+    run<SpecialFunc::Tan, Native>();
+    run<SpecialFunc::Rsqrt, Native>();
+    run<SpecialFunc::Sqrt, Native>();
+    run<SpecialFunc::Pow, Native>();
+    if constexpr(!Native)
+      run<SpecialFunc::Erf, Native>();
+  }
+
+  void emit() {
+    auto& consumer = *app.getArgs().result_consumer;
+    consumer.proceedToBenchmark(std::string{"MicroBench_sf_"} + ReadableTypename<DataT>::name + "_Table");
+    consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+    consumer.consumeResult("throughput-per-function", "\"" + throughputs.str() + "\"", "GOP/s");
+    consumer.consumeResult("max-ulp-per-function", "\"" + max_ulps.str() + "\"", "ULP");
+    consumer.flush();
+  }
+};
+
 int main(int argc, char** argv) {
   BenchmarkApp app(argc, argv);
 
@@ -88,5 +365,17 @@ int main(int argc, char** argv) {
   if(app.deviceSupportsFP64())
     app.run<MicroBenchSpecialFunc<double>>();
 
+  // Individual functions. native:: functions are only available for fp32.
+  SpecialFuncTable<float> table_fp32{app};
+  table_fp32.runAll<false>();
+  table_fp32.runAll<true>();
+  table_fp32.emit();
+
+  if(app.deviceSupportsFP64()) {
+    SpecialFuncTable<double> table_fp64{app};
+    table_fp64.runAll<false>();
+    table_fp64.emit();
+  }
+
   return 0;
 }
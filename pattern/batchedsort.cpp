@@ -0,0 +1,209 @@
+#include "common.h"
+
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <vector>
+
+using namespace cl;
+
+// Local memory used per work group when every sub-group sorts its own arrays,
+// unless the device has less local memory
+constexpr std::size_t SUB_GROUP_SORT_LOCAL_MEM_BYTES = 32 * 1024;
+
+// Which group sorts one array:
+//  * WorkGroup: one work group of min(ArrayLength / 2, local_size) work items per array.
+//  * SubGroup: every work group holds several arrays in local memory, each sorted by one sub-group,
+//    such that only sub-group barriers are needed.
+enum class SortGroup { WorkGroup, SubGroup };
+
+template <typename T, int ArrayLength, SortGroup Group> class BatchedSortKernel;
+
+// Sorts many small arrays of ArrayLength elements independently with a bitonic sorting network
+// in local memory, as e.g. for per-pixel or per-row sorting. The problem size is the total number of elements.
+template <typename T, int ArrayLength, SortGroup Group>
+class BatchedSort
+{
+  static_assert(ArrayLength >= 2 && (ArrayLength & (ArrayLength - 1)) == 0, "Array length must be a power of two");
+
+protected:
+    std::vector<T> _input;
+    BenchmarkArgs _args;
+
+    std::size_t _num_arrays;
+    std::size_t _arrays_per_group;
+    std::size_t _group_size;
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<T, 1> _output_buff;
+public:
+  BatchedSort(const BenchmarkArgs &args)
+    : _args{args}
+  {
+    assert(_args.problem_size % ArrayLength == 0);
+  }
+
+  void generate_input(std::vector<T>& out)
+  {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> dist{0, 1 << 20};
+
+    out.resize(_args.problem_size);
+    for(std::size_t i = 0; i < out.size(); ++i)
+      out[i] = static_cast<T>(dist(rng));
+  }
+
+  // Number of arrays sorted by one work group that fit into the local memory of the device,
+  // 0 if not even a single array fits.
+  static std::size_t getArraysPerGroup(const sycl::device& device) {
+    const std::size_t local_mem_size = device.get_info<sycl::info::device::local_mem_size>();
+    const std::size_t max_arrays = Group == SortGroup::WorkGroup
+        ? 1 : std::max<std::size_t>(SUB_GROUP_SORT_LOCAL_MEM_BYTES / (ArrayLength * sizeof(T)), 1);
+    return std::min(max_arrays, local_mem_size / (ArrayLength * sizeof(T)));
+  }
+
+  void setup() {
+    generate_input(_input);
+
+    _num_arrays = _args.problem_size / ArrayLength;
+    _arrays_per_group = getArraysPerGroup(_args.device_queue.get_device());
+    if(Group == SortGroup::WorkGroup)
+      _group_size = std::min<std::size_t>(ArrayLength / 2, _args.local_size);
+    else
+      _group_size = _args.local_size;
+
+    _input_buff.initialize(_args.device_queue, _input.data(), sycl::range<1>(_args.problem_size));
+    _output_buff.initialize(_args.device_queue, sycl::range<1>(_args.problem_size));
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+      auto scratch = sycl::accessor<T, 1, mode::read_write, target::local>
+        {_arrays_per_group * ArrayLength, cgh};
+
+      const std::size_t num_arrays = _num_arrays;
+      const std::size_t arrays_per_group = _arrays_per_group;
+      const std::size_t num_groups = (_num_arrays + _arrays_per_group - 1) / _arrays_per_group;
+
+      cgh.parallel_for<BatchedSortKernel<T, ArrayLength, Group>>(
+        sycl::nd_range<1>{num_groups * _group_size, _group_size},
+        [=](sycl::nd_item<1> item) {
+          if constexpr(Group == SortGroup::WorkGroup) {
+            const std::size_t offset = item.get_group(0) * ArrayLength;
+            sort_array(item.get_group(), item.get_local_id(0), item.get_local_range(0), acc, acc_out, scratch, offset,
+                       0);
+          } else {
+            auto sg = item.get_sub_group();
+            const std::size_t first_array = item.get_group(0) * arrays_per_group;
+
+            for(std::size_t a = sg.get_group_linear_id(); a < arrays_per_group; a += sg.get_group_linear_range()) {
+              if(first_array + a < num_arrays)
+                sort_array(sg, sg.get_local_linear_id(), sg.get_local_linear_range(), acc, acc_out, scratch,
+                           (first_array + a) * ArrayLength, a * ArrayLength);
+            }
+          }
+        });
+    })); // submit
+  }
+
+  bool verify(VerificationSetting &ver) {
+    auto result = _output_buff.template get_access<sycl::access::mode::read>();
+
+    std::vector<T> expected(ArrayLength);
+    for(std::size_t a = 0; a < _num_arrays; ++a) {
+      std::copy(_input.begin() + a * ArrayLength, _input.begin() + (a + 1) * ArrayLength, expected.begin());
+      std::sort(expected.begin(), expected.end());
+      for(std::size_t i = 0; i < ArrayLength; ++i) {
+        if(result[a * ArrayLength + i] != expected[i])
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size / ArrayLength) / 1.0e6, "Marrays"};
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_BatchedSort_";
+    name << (Group == SortGroup::WorkGroup ? "WorkGroup_" : "SubGroup_");
+    name << ReadableTypename<T>::name << "_";
+    name << ArrayLength;
+    return name.str();
+  }
+
+private:
+  // Bitonic sort of one array in local memory by the work items of group g.
+  // Each stage consists of ArrayLength / 2 independent compare-exchange operations.
+  template <class G, class InAccessor, class OutAccessor, class LocalAccessor>
+  static void sort_array(const G& g, std::size_t lid, std::size_t group_size, const InAccessor& acc,
+                         const OutAccessor& acc_out, const LocalAccessor& scratch, std::size_t offset,
+                         std::size_t local_offset)
+  {
+    for(std::size_t i = lid; i < ArrayLength; i += group_size)
+      scratch[local_offset + i] = acc[offset + i];
+
+    for(std::size_t k = 2; k <= ArrayLength; k *= 2) {
+      for(std::size_t j = k / 2; j > 0; j /= 2) {
+        sycl::group_barrier(g);
+        for(std::size_t c = lid; c < ArrayLength / 2; c += group_size) {
+          // Compare element i with its partner i + j, in ascending order if bit k of i is clear
+          const std::size_t i = (c / j) * 2 * j + c % j;
+          const bool ascending = (i & k) == 0;
+          const T a = scratch[local_offset + i];
+          const T b = scratch[local_offset + i + j];
+          if((a > b) == ascending) {
+            scratch[local_offset + i] = b;
+            scratch[local_offset + i + j] = a;
+          }
+        }
+      }
+    }
+
+    sycl::group_barrier(g);
+    for(std::size_t i = lid; i < ArrayLength; i += group_size)
+      acc_out[offset + i] = scratch[local_offset + i];
+  }
+};
+
+template<class T, int ArrayLength, SortGroup Group>
+void runArrayLength(BenchmarkApp& app)
+{
+  using Benchmark = BatchedSort<T, ArrayLength, Group>;
+
+  // Arrays larger than the local memory are not supported
+  if(Benchmark::getArraysPerGroup(app.getArgs().device_queue.get_device()) == 0)
+    return;
+  app.run<Benchmark>();
+}
+
+template<class T, SortGroup Group>
+void runArrayLengths(BenchmarkApp& app)
+{
+  runArrayLength<T, 16, Group>(app);
+  runArrayLength<T, 32, Group>(app);
+  runArrayLength<T, 64, Group>(app);
+  runArrayLength<T, 128, Group>(app);
+  runArrayLength<T, 256, Group>(app);
+  runArrayLength<T, 512, Group>(app);
+  runArrayLength<T, 1024, Group>(app);
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  if(app.shouldRunNDRangeKernels()) {
+    runArrayLengths<int, SortGroup::WorkGroup>(app);
+    runArrayLengths<int, SortGroup::SubGroup>(app);
+    runArrayLengths<float, SortGroup::WorkGroup>(app);
+    runArrayLengths<float, SortGroup::SubGroup>(app);
+  }
+
+  return 0;
+}
@@ -0,0 +1,224 @@
+#include "common.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace cl;
+
+// Number of consecutive chunks of local_size elements processed by every work group
+constexpr std::size_t ITEMS_PER_WORK_ITEM = 16;
+// Maximum number of histogram copies per work group of the SubGroupReplicated strategy
+constexpr std::size_t MAX_SUB_GROUP_REPLICAS = 8;
+
+// How the bin counters are updated:
+//  * GlobalAtomics: every element increments its bin in the global histogram with an atomic.
+//  * WorkGroupPrivatized: every work group accumulates a private histogram in local memory
+//    with local atomics, which is merged into the global histogram at the end.
+//  * SubGroupReplicated: like WorkGroupPrivatized, but with several copies of the local histogram
+//    per work group, each shared by fewer sub-groups, to reduce the contention on hot bins.
+enum class HistogramStrategy { GlobalAtomics, WorkGroupPrivatized, SubGroupReplicated };
+
+// Distribution of the input values:
+//  * Uniform: uniformly distributed over the range of the input type.
+//  * Skewed: geometrically distributed (p = 0.1) such that about 65% of the elements fall into
+//    the 10 lowest bins, as e.g. in the luminance histogram of a dark image.
+enum class HistogramDistribution { Uniform, Skewed };
+
+template <typename T, HistogramStrategy Strategy, HistogramDistribution Distribution> class HistogramKernel;
+
+// Counts the elements of the input per bin, with the bin of an element given by its lowest bits.
+template <typename T, HistogramStrategy Strategy, HistogramDistribution Distribution>
+class Histogram
+{
+protected:
+    std::vector<T> _input;
+    std::vector<unsigned int> _histogram;
+    BenchmarkArgs _args;
+    const std::size_t _num_bins;
+
+    std::size_t _num_replicas;
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<unsigned int, 1> _histogram_buff;
+public:
+  Histogram(const BenchmarkArgs &args, std::size_t num_bins)
+    : _args{args}, _num_bins{num_bins}
+  {
+    assert(_num_bins > 0 && (_num_bins & (_num_bins - 1)) == 0);
+    assert(_num_bins - 1 <= std::numeric_limits<T>::max());
+  }
+
+  void generate_input(std::vector<T>& out)
+  {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<unsigned long long> uniform{0, std::numeric_limits<T>::max()};
+    std::geometric_distribution<unsigned long long> skewed{0.1};
+
+    out.resize(_args.problem_size);
+    for(std::size_t i = 0; i < out.size(); ++i) {
+      if(Distribution == HistogramDistribution::Uniform)
+        out[i] = static_cast<T>(uniform(rng));
+      else
+        out[i] = static_cast<T>(std::min<unsigned long long>(skewed(rng), std::numeric_limits<T>::max()));
+    }
+  }
+
+  // Number of copies of the local histogram fitting into the local memory of the device,
+  // 0 if the strategy needs a local histogram and not even a single one fits.
+  static std::size_t getNumReplicas(const sycl::device& device, std::size_t num_bins) {
+    if(Strategy == HistogramStrategy::GlobalAtomics)
+      return 0;
+
+    const std::size_t local_mem_size = device.get_info<sycl::info::device::local_mem_size>();
+    const std::size_t max_replicas =
+        Strategy == HistogramStrategy::SubGroupReplicated ? MAX_SUB_GROUP_REPLICAS : 1;
+    return std::min(max_replicas, local_mem_size / (num_bins * sizeof(unsigned int)));
+  }
+
+  void setup() {
+    generate_input(_input);
+    _histogram.assign(_num_bins, 0);
+    _num_replicas = getNumReplicas(_args.device_queue.get_device(), _num_bins);
+
+    _input_buff.initialize(_args.device_queue, _input.data(), sycl::range<1>(_args.problem_size));
+    _histogram_buff.initialize(_args.device_queue, _histogram.data(), sycl::range<1>(_num_bins));
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto histogram = _histogram_buff.template get_access<mode::read_write>(cgh);
+      auto local_histograms = sycl::accessor<unsigned int, 1, mode::read_write, target::local>
+        {std::max<std::size_t>(_num_replicas * _num_bins, 1), cgh};
+
+      const std::size_t n = _args.problem_size;
+      const std::size_t local_size = _args.local_size;
+      const std::size_t num_bins = _num_bins;
+      const std::size_t num_replicas = _num_replicas;
+      const std::size_t elements_per_group = local_size * ITEMS_PER_WORK_ITEM;
+      const std::size_t num_groups = (n + elements_per_group - 1) / elements_per_group;
+
+      cgh.parallel_for<HistogramKernel<T, Strategy, Distribution>>(
+        sycl::nd_range<1>{num_groups * local_size, local_size},
+        [=](sycl::nd_item<1> item) {
+          const std::size_t lid = item.get_local_id(0);
+          const std::size_t group_offset = item.get_group(0) * elements_per_group;
+
+          if constexpr(Strategy == HistogramStrategy::GlobalAtomics) {
+            for(std::size_t i = 0; i < ITEMS_PER_WORK_ITEM; ++i) {
+              const std::size_t gid = group_offset + i * local_size + lid;
+              if(gid < n) {
+                const std::size_t bin = acc[gid] & (num_bins - 1);
+                sycl::atomic_ref<unsigned int, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                                 address_space::global_space>{histogram[bin]}.fetch_add(1u);
+              }
+            }
+          } else {
+            // Sub-groups are distributed round-robin across the local histograms
+            const std::size_t replica = item.get_sub_group().get_group_linear_id() % num_replicas;
+
+            for(std::size_t b = lid; b < num_replicas * num_bins; b += local_size)
+              local_histograms[b] = 0;
+            item.barrier(fence_space::local_space);
+
+            for(std::size_t i = 0; i < ITEMS_PER_WORK_ITEM; ++i) {
+              const std::size_t gid = group_offset + i * local_size + lid;
+              if(gid < n) {
+                const std::size_t bin = acc[gid] & (num_bins - 1);
+                sycl::atomic_ref<unsigned int, sycl::memory_order::relaxed, sycl::memory_scope::work_group,
+                                 address_space::local_space>{local_histograms[replica * num_bins + bin]}
+                    .fetch_add(1u);
+              }
+            }
+            item.barrier(fence_space::local_space);
+
+            // Merge the local histograms into the global histogram, skipping empty bins
+            for(std::size_t b = lid; b < num_bins; b += local_size) {
+              unsigned int count = 0;
+              for(std::size_t r = 0; r < num_replicas; ++r)
+                count += local_histograms[r * num_bins + b];
+              if(count > 0)
+                sycl::atomic_ref<unsigned int, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                                 address_space::global_space>{histogram[b]}.fetch_add(count);
+            }
+          }
+        });
+    })); // submit
+  }
+
+  bool verify(VerificationSetting &ver) {
+    std::vector<unsigned int> expected(_num_bins, 0);
+    for(T x : _input)
+      ++expected[x & (_num_bins - 1)];
+
+    auto result = _histogram_buff.template get_access<sycl::access::mode::read>();
+    for(std::size_t b = 0; b < _num_bins; ++b) {
+      if(result[b] != expected[b])
+        return false;
+    }
+    return true;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size) / 1.0e9, "Gelem"};
+  }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << "Pattern_Histogram_";
+    switch(Strategy) {
+    case HistogramStrategy::GlobalAtomics: name << "GlobalAtomics_"; break;
+    case HistogramStrategy::WorkGroupPrivatized: name << "WorkGroupPrivatized_"; break;
+    case HistogramStrategy::SubGroupReplicated: name << "SubGroupReplicated_"; break;
+    }
+    name << (Distribution == HistogramDistribution::Uniform ? "Uniform_" : "Skewed_");
+    name << ReadableTypename<T>::name << "_";
+    name << _num_bins << "Bins";
+    return name.str();
+  }
+};
+
+template <typename T, HistogramStrategy Strategy, HistogramDistribution Distribution>
+void runBinCounts(BenchmarkApp& app, const std::vector<std::size_t>& bin_counts)
+{
+  using Benchmark = Histogram<T, Strategy, Distribution>;
+
+  const auto device = app.getArgs().device_queue.get_device();
+  for(std::size_t num_bins : bin_counts) {
+    // Local histograms larger than the local memory are not supported
+    if(Strategy != HistogramStrategy::GlobalAtomics && Benchmark::getNumReplicas(device, num_bins) == 0)
+      continue;
+    app.run<Benchmark>(num_bins);
+  }
+}
+
+template <typename T, HistogramDistribution Distribution>
+void runStrategies(BenchmarkApp& app, const std::vector<std::size_t>& bin_counts)
+{
+  runBinCounts<T, HistogramStrategy::GlobalAtomics, Distribution>(app, bin_counts);
+  runBinCounts<T, HistogramStrategy::WorkGroupPrivatized, Distribution>(app, bin_counts);
+  runBinCounts<T, HistogramStrategy::SubGroupReplicated, Distribution>(app, bin_counts);
+}
+
+template <typename T>
+void runDistributions(BenchmarkApp& app, const std::vector<std::size_t>& bin_counts)
+{
+  runStrategies<T, HistogramDistribution::Uniform>(app, bin_counts);
+  runStrategies<T, HistogramDistribution::Skewed>(app, bin_counts);
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  if(app.shouldRunNDRangeKernels()) {
+    runDistributions<unsigned char>(app, {16, 64, 256});
+    runDistributions<unsigned int>(app, {16, 256, 1024, 4096, 16384, 65536});
+  }
+
+  return 0;
+}
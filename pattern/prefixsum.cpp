@@ -1 +1,351 @@
-TODO: SYCL code with a prefix sum
+#include "common.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace cl;
+
+// The input values are uniformly distributed in [0, VALUE_RANGE), an element
+// is selected if its value is below selectivity * VALUE_RANGE / 100.
+constexpr int VALUE_RANGE = 100000;
+
+// How the selected elements are compacted:
+//  * ThreePass: a flag kernel writing one flag per element and the number of selected
+//    elements per work group, an exclusive scan of the group counts, and a scatter kernel.
+//    The output preserves the order of the input.
+//  * Partition: like ThreePass, but the scatter kernel also writes the rejected elements behind
+//    the selected ones, in the order of the input (a stable partition).
+//  * Fused: a single kernel in which every work group compacts its selected elements in local memory
+//    and reserves its output range with an atomic on a global counter. The order of the work groups
+//    in the output depends on the scheduling.
+enum class CompactionVariant { ThreePass, Partition, Fused };
+
+// Number of elements selected by the predicate, used to compute the output bandwidth.
+using SelectedCount = std::size_t;
+
+template <typename T, CompactionVariant Variant> class CompactionKernelFlag;
+template <typename T, CompactionVariant Variant> class CompactionKernelGroupOffsets;
+template <typename T, CompactionVariant Variant> class CompactionKernelScatter;
+template <typename T> class CompactionKernelFused;
+
+// Stream compaction: copies all elements of the input satisfying a predicate
+// to the front of the output, as e.g. in the filter stage of a database query.
+// The partition variant additionally keeps the rejected elements.
+template <typename T, CompactionVariant Variant>
+class StreamCompaction
+{
+protected:
+    std::vector<T> _input;
+    std::vector<T> _expected;
+    std::vector<int> _counter;
+    BenchmarkArgs _args;
+    const int _selectivity;
+    SelectedCount& _selected_count;
+
+    std::size_t _num_groups;
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<T, 1> _output_buff;
+    PrefetchedBuffer<int, 1> _flags_buff;
+    PrefetchedBuffer<int, 1> _group_counts_buff;
+    // Output offset of every work group, followed by the total number of selected elements
+    PrefetchedBuffer<int, 1> _group_offsets_buff;
+    PrefetchedBuffer<int, 1> _counter_buff;
+public:
+  StreamCompaction(const BenchmarkArgs &args, int selectivity, SelectedCount& selected_count)
+    : _args{args}, _selectivity{selectivity}, _selected_count{selected_count}
+  {
+    assert(_selectivity >= 0 && _selectivity <= 100);
+  }
+
+  void generate_input(std::vector<T>& out)
+  {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> dist{0, VALUE_RANGE - 1};
+
+    out.resize(_args.problem_size);
+    for(std::size_t i = 0; i < out.size(); ++i)
+      out[i] = static_cast<T>(dist(rng));
+  }
+
+  T get_threshold() const {
+    return static_cast<T>(static_cast<long long>(VALUE_RANGE) * _selectivity / 100);
+  }
+
+  void setup() {
+    generate_input(_input);
+
+    const T threshold = get_threshold();
+    _expected.clear();
+    std::copy_if(_input.begin(), _input.end(), std::back_inserter(_expected),
+                 [=](T x) { return x < threshold; });
+    _selected_count = _expected.size();
+    if(Variant == CompactionVariant::Partition)
+      std::copy_if(_input.begin(), _input.end(), std::back_inserter(_expected),
+                   [=](T x) { return !(x < threshold); });
+
+    _num_groups = (_args.problem_size + _args.local_size - 1) / _args.local_size;
+
+    _input_buff.initialize(_args.device_queue, static_cast<const T*>(_input.data()), sycl::range<1>(_args.problem_size));
+    _output_buff.initialize(_args.device_queue, sycl::range<1>{_args.problem_size});
+
+    if constexpr(Variant == CompactionVariant::Fused) {
+      _counter.assign(1, 0);
+      _counter_buff.initialize(_args.device_queue, _counter.data(), sycl::range<1>{1});
+    } else {
+      _flags_buff.initialize(_args.device_queue, sycl::range<1>{_args.problem_size});
+      _group_counts_buff.initialize(_args.device_queue, sycl::range<1>{_num_groups});
+      _group_offsets_buff.initialize(_args.device_queue, sycl::range<1>{_num_groups + 1});
+    }
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    if constexpr(Variant == CompactionVariant::Fused) {
+      events.push_back(submit_fused());
+    } else {
+      events.push_back(submit_flags());
+      events.push_back(submit_group_offsets());
+      events.push_back(submit_scatter());
+    }
+  }
+
+  bool verify(VerificationSetting &ver) {
+    std::vector<T> expected = _expected;
+
+    std::size_t num_selected;
+    if constexpr(Variant == CompactionVariant::Fused)
+      num_selected = _counter_buff.template get_access<sycl::access::mode::read>()[0];
+    else
+      num_selected = _group_offsets_buff.template get_access<sycl::access::mode::read>()[_num_groups];
+
+    if(num_selected != _selected_count)
+      return false;
+
+    auto output = _output_buff.template get_access<sycl::access::mode::read>();
+    std::vector<T> result(expected.size());
+    for(std::size_t i = 0; i < result.size(); ++i)
+      result[i] = output[i];
+
+    // The fused variant only preserves the order within a work group
+    if constexpr(Variant == CompactionVariant::Fused) {
+      std::sort(result.begin(), result.end());
+      std::sort(expected.begin(), expected.end());
+    }
+    return result == expected;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size) / 1.0e9, "Gelem"};
+  }
+
+  static std::string getVariantName() {
+    switch(Variant) {
+    case CompactionVariant::ThreePass: return "ThreePass";
+    case CompactionVariant::Partition: return "Partition";
+    case CompactionVariant::Fused: return "Fused";
+    }
+    return "";
+  }
+
+  std::string getBenchmarkName() const {
+    std::stringstream name;
+    name << "Pattern_StreamCompaction_";
+    name << getVariantName() << "_";
+    name << ReadableTypename<T>::name << "_";
+    name << _selectivity << "Percent";
+    return name.str();
+  }
+
+private:
+  sycl::nd_range<1> get_nd_range() const {
+    return sycl::nd_range<1>{_num_groups * _args.local_size, _args.local_size};
+  }
+
+  sycl::event submit_flags()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto flags = _flags_buff.template get_access<mode::discard_write>(cgh);
+      auto group_counts = _group_counts_buff.template get_access<mode::discard_write>(cgh);
+
+      const std::size_t n = _args.problem_size;
+      const T threshold = get_threshold();
+
+      cgh.parallel_for<CompactionKernelFlag<T, Variant>>(
+        get_nd_range(),
+        [=](sycl::nd_item<1> item) {
+          const std::size_t gid = item.get_global_id(0);
+
+          const int flag = (gid < n && acc[gid] < threshold) ? 1 : 0;
+          if(gid < n)
+            flags[gid] = flag;
+
+          const int count = sycl::reduce_over_group(item.get_group(), flag, sycl::plus<int>());
+          if(item.get_local_id(0) == 0)
+            group_counts[item.get_group(0)] = count;
+        });
+    }); // submit
+  }
+
+  sycl::event submit_group_offsets()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto group_counts = _group_counts_buff.template get_access<mode::read>(cgh);
+      auto group_offsets = _group_offsets_buff.template get_access<mode::discard_write>(cgh);
+
+      const std::size_t num_groups = _num_groups;
+
+      // A single work group scans the counts of all work groups
+      cgh.parallel_for<CompactionKernelGroupOffsets<T, Variant>>(
+        sycl::nd_range<1>{_args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          auto grp = item.get_group();
+          sycl::joint_exclusive_scan(grp, &group_counts[0], &group_counts[0] + num_groups, &group_offsets[0], 0,
+                                     sycl::plus<int>());
+
+          sycl::group_barrier(grp);
+          if(item.get_local_id(0) == 0)
+            group_offsets[num_groups] = group_offsets[num_groups - 1] + group_counts[num_groups - 1];
+        });
+    }); // submit
+  }
+
+  sycl::event submit_scatter()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto flags = _flags_buff.template get_access<mode::read>(cgh);
+      auto group_offsets = _group_offsets_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+
+      const std::size_t n = _args.problem_size;
+      const std::size_t num_groups = _num_groups;
+
+      cgh.parallel_for<CompactionKernelScatter<T, Variant>>(
+        get_nd_range(),
+        [=](sycl::nd_item<1> item) {
+          const std::size_t gid = item.get_global_id(0);
+
+          const int flag = (gid < n) ? flags[gid] : 0;
+          const int local_offset = sycl::exclusive_scan_over_group(item.get_group(), flag, sycl::plus<int>());
+          const std::size_t selected_before = group_offsets[item.get_group(0)] + local_offset;
+          if(flag)
+            acc_out[selected_before] = acc[gid];
+
+          if constexpr(Variant == CompactionVariant::Partition) {
+            // The rejected elements follow all selected ones, preceded by the rejected elements before gid
+            if(gid < n && !flag)
+              acc_out[group_offsets[num_groups] + gid - selected_before] = acc[gid];
+          }
+        });
+    }); // submit
+  }
+
+  sycl::event submit_fused()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+      auto counter = _counter_buff.template get_access<mode::read_write>(cgh);
+      auto scratch = sycl::accessor<T, 1, mode::read_write, target::local>
+        {_args.local_size, cgh};
+
+      const std::size_t n = _args.problem_size;
+      const T threshold = get_threshold();
+
+      cgh.parallel_for<CompactionKernelFused<T>>(
+        get_nd_range(),
+        [=](sycl::nd_item<1> item) {
+          auto grp = item.get_group();
+          const std::size_t gid = item.get_global_id(0);
+          const int lid = item.get_local_id(0);
+
+          const T x = (gid < n) ? acc[gid] : T{0};
+          const int flag = (gid < n && x < threshold) ? 1 : 0;
+
+          // Compact the selected elements of the work group in local memory
+          const int local_offset = sycl::exclusive_scan_over_group(grp, flag, sycl::plus<int>());
+          const int count = sycl::reduce_over_group(grp, flag, sycl::plus<int>());
+          if(flag)
+            scratch[local_offset] = x;
+
+          int base = 0;
+          if(lid == 0 && count > 0)
+            base = sycl::atomic_ref<int, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                                    address_space::global_space>{counter[0]}.fetch_add(count);
+          base = sycl::group_broadcast(grp, base, 0);
+
+          item.barrier(fence_space::local_space);
+          if(lid < count)
+            acc_out[base + lid] = scratch[lid];
+        });
+    }); // submit
+  }
+};
+
+// Runs the benchmark for every selectivity and emits the output bandwidth
+// in bytes of output elements per second.
+template <typename T, CompactionVariant Variant>
+void runSelectivities(BenchmarkApp& app, const std::vector<int>& selectivities)
+{
+  std::stringstream curve;
+  for(int selectivity : selectivities) {
+    SelectedCount selected_count = 0;
+    const auto time = app.run<StreamCompaction<T, Variant>>(selectivity, selected_count);
+
+    // The partition writes all elements
+    const std::size_t num_output =
+        Variant == CompactionVariant::Partition ? app.getArgs().problem_size : selected_count;
+
+    if(!curve.str().empty())
+      curve << " ";
+    curve << selectivity << "%:";
+    if(time && num_output > 0)
+      curve << std::to_string(num_output * sizeof(T) / 1024.0 / 1024.0 / 1024.0 / (time->count() / 1.0e9));
+    else
+      curve << "N/A";
+  }
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark("Pattern_StreamCompaction_" + StreamCompaction<T, Variant>::getVariantName() + "_" +
+                              ReadableTypename<T>::name + "_Output");
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  consumer.consumeResult("output-bandwidth-per-selectivity", "\"" + curve.str() + "\"", "GiB/s");
+  consumer.flush();
+}
+
+template <typename T>
+void runVariants(BenchmarkApp& app, const std::vector<int>& selectivities)
+{
+  runSelectivities<T, CompactionVariant::ThreePass>(app, selectivities);
+  runSelectivities<T, CompactionVariant::Partition>(app, selectivities);
+  runSelectivities<T, CompactionVariant::Fused>(app, selectivities);
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  // A single selectivity in percent can be chosen using --selectivity=<percent>
+  std::vector<int> selectivities = {1, 10, 25, 50, 75, 90, 99};
+  const int selectivity = app.getArgs().cli.getOrDefault<int>("--selectivity", 0);
+  if(selectivity > 0)
+    selectivities = {selectivity};
+
+  if(app.shouldRunNDRangeKernels()) {
+    runVariants<int>(app, selectivities);
+    runVariants<long long>(app, selectivities);
+  }
+
+  return 0;
+}
@@ -0,0 +1,307 @@
+#include "common.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace cl;
+
+// Number of key bits sorted per pass
+constexpr int RADIX_BITS = 4;
+constexpr int RADIX = 1 << RADIX_BITS;
+// Number of keys per work item and pass. Every work group processes a tile of
+// ITEMS_PER_WORK_ITEM * local_size keys, in chunks of local_size keys.
+constexpr int ITEMS_PER_WORK_ITEM = 4;
+
+// Distribution of the keys:
+//  * Uniform: uniformly distributed over all bits.
+//  * Sorted: uniformly distributed, but already in ascending order.
+//  * LowEntropy: bitwise AND of four uniform keys, i.e. every bit is set with a probability of 1/16.
+enum class KeyDistribution { Uniform, Sorted, LowEntropy };
+
+template <typename KeyT, bool WithPayload, KeyDistribution Distribution> class RadixSortKernelHistogram;
+template <typename KeyT, bool WithPayload, KeyDistribution Distribution> class RadixSortKernelOffsets;
+template <typename KeyT, bool WithPayload, KeyDistribution Distribution> class RadixSortKernelScatter;
+
+// Least-significant-digit radix sort. Every pass sorts the keys stably by RADIX_BITS bits with
+// three kernels: a histogram of the digits per work group, an exclusive scan of the histograms
+// (per digit over all work groups) and a scatter of the keys to their new positions.
+// Optionally, a 32-bit payload (the original index of the key) is moved along with the keys.
+template <typename KeyT, bool WithPayload, KeyDistribution Distribution>
+class RadixSort
+{
+protected:
+    std::vector<KeyT> _keys;
+    std::vector<unsigned int> _values;
+    BenchmarkArgs _args;
+
+    std::size_t _num_groups;
+    // The sorted keys and values end up in the first buffer, since the number of passes is even
+    PrefetchedBuffer<KeyT, 1> _keys_buff[2];
+    PrefetchedBuffer<unsigned int, 1> _values_buff[2];
+    // Digit counts of every work group, stored digit-major: counts[digit * num_groups + group]
+    PrefetchedBuffer<int, 1> _counts_buff;
+    PrefetchedBuffer<int, 1> _offsets_buff;
+    PrefetchedBuffer<int, 1> _digit_totals_buff;
+
+    static constexpr int num_passes = sizeof(KeyT) * 8 / RADIX_BITS;
+    static_assert(num_passes % 2 == 0, "The sorted keys are expected in the first buffer");
+public:
+  RadixSort(const BenchmarkArgs &args)
+    : _args{args}
+  {}
+
+  void generate_input()
+  {
+    std::mt19937_64 rng{42};
+    std::uniform_int_distribution<KeyT> dist;
+
+    _keys.resize(_args.problem_size);
+    for(std::size_t i = 0; i < _keys.size(); ++i) {
+      if(Distribution == KeyDistribution::LowEntropy)
+        _keys[i] = dist(rng) & dist(rng) & dist(rng) & dist(rng);
+      else
+        _keys[i] = dist(rng);
+    }
+    if(Distribution == KeyDistribution::Sorted)
+      std::sort(_keys.begin(), _keys.end());
+
+    _values.resize(_args.problem_size);
+    std::iota(_values.begin(), _values.end(), 0);
+  }
+
+  void setup() {
+    generate_input();
+
+    const std::size_t tile_size = ITEMS_PER_WORK_ITEM * _args.local_size;
+    _num_groups = (_args.problem_size + tile_size - 1) / tile_size;
+
+    _keys_buff[0].initialize(_args.device_queue, _keys.data(), sycl::range<1>{_args.problem_size});
+    _keys_buff[1].initialize(_args.device_queue, sycl::range<1>{_args.problem_size});
+    if(WithPayload) {
+      _values_buff[0].initialize(_args.device_queue, _values.data(), sycl::range<1>{_args.problem_size});
+      _values_buff[1].initialize(_args.device_queue, sycl::range<1>{_args.problem_size});
+    } else {
+      // Not accessed by the kernels
+      _values_buff[0].initialize(_args.device_queue, sycl::range<1>{1});
+      _values_buff[1].initialize(_args.device_queue, sycl::range<1>{1});
+    }
+    _counts_buff.initialize(_args.device_queue, sycl::range<1>{RADIX * _num_groups});
+    _offsets_buff.initialize(_args.device_queue, sycl::range<1>{RADIX * _num_groups});
+    _digit_totals_buff.initialize(_args.device_queue, sycl::range<1>{RADIX});
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    for(int pass = 0; pass < num_passes; ++pass) {
+      const int src = pass % 2;
+      events.push_back(submit_histogram(pass, src));
+      events.push_back(submit_offsets());
+      events.push_back(submit_scatter(pass, src));
+    }
+  }
+
+  bool verify(VerificationSetting &ver) {
+    std::vector<std::size_t> order(_keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return _keys[a] < _keys[b]; });
+
+    auto keys = _keys_buff[0].template get_access<sycl::access::mode::read>();
+    for(std::size_t i = 0; i < order.size(); ++i) {
+      if(keys[i] != _keys[order[i]])
+        return false;
+    }
+
+    if(WithPayload) {
+      // The sort is stable, so the payload is unique
+      auto values = _values_buff[0].template get_access<sycl::access::mode::read>();
+      for(std::size_t i = 0; i < order.size(); ++i) {
+        if(values[i] != order[i])
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size) / 1.0e9, "Gkeys"};
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_RadixSort_";
+    name << ReadableTypename<KeyT>::name << "_";
+    name << (WithPayload ? "KeyValue_" : "Keys_");
+    switch(Distribution) {
+    case KeyDistribution::Uniform: name << "Uniform"; break;
+    case KeyDistribution::Sorted: name << "Sorted"; break;
+    case KeyDistribution::LowEntropy: name << "LowEntropy"; break;
+    }
+    return name.str();
+  }
+
+private:
+  static int get_digit(KeyT key, int pass) {
+    return static_cast<int>((key >> (pass * RADIX_BITS)) & (RADIX - 1));
+  }
+
+  sycl::nd_range<1> get_nd_range() const {
+    return sycl::nd_range<1>{_num_groups * _args.local_size, _args.local_size};
+  }
+
+  sycl::event submit_histogram(int pass, int src)
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto keys = _keys_buff[src].template get_access<mode::read>(cgh);
+      auto counts = _counts_buff.template get_access<mode::discard_write>(cgh);
+      auto histogram = sycl::accessor<int, 1, mode::read_write, target::local>{RADIX, cgh};
+
+      const std::size_t n = _args.problem_size;
+      const std::size_t num_groups = _num_groups;
+
+      cgh.parallel_for<RadixSortKernelHistogram<KeyT, WithPayload, Distribution>>(
+        get_nd_range(),
+        [=](sycl::nd_item<1> item) {
+          const int lid = item.get_local_id(0);
+          const int group_size = item.get_local_range(0);
+          const std::size_t group = item.get_group(0);
+          const std::size_t tile_begin = group * ITEMS_PER_WORK_ITEM * group_size;
+
+          for(int b = lid; b < RADIX; b += group_size)
+            histogram[b] = 0;
+          item.barrier(fence_space::local_space);
+
+          for(int c = 0; c < ITEMS_PER_WORK_ITEM; ++c) {
+            const std::size_t i = tile_begin + c * group_size + lid;
+            if(i < n)
+              sycl::atomic_ref<int, sycl::memory_order::relaxed, sycl::memory_scope::work_group,
+                               address_space::local_space>{histogram[get_digit(keys[i], pass)]}.fetch_add(1);
+          }
+          item.barrier(fence_space::local_space);
+
+          for(int b = lid; b < RADIX; b += group_size)
+            counts[b * num_groups + group] = histogram[b];
+        });
+    }); // submit
+  }
+
+  sycl::event submit_offsets()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto counts = _counts_buff.template get_access<mode::read>(cgh);
+      auto offsets = _offsets_buff.template get_access<mode::discard_write>(cgh);
+      auto digit_totals = _digit_totals_buff.template get_access<mode::discard_write>(cgh);
+
+      const std::size_t num_groups = _num_groups;
+
+      // One work group per digit scans the counts of this digit over all work groups
+      cgh.parallel_for<RadixSortKernelOffsets<KeyT, WithPayload, Distribution>>(
+        sycl::nd_range<1>{RADIX * _args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          auto grp = item.get_group();
+          const std::size_t row = item.get_group(0) * num_groups;
+
+          sycl::joint_exclusive_scan(grp, &counts[row], &counts[row] + num_groups, &offsets[row], 0,
+                                     sycl::plus<int>());
+
+          sycl::group_barrier(grp);
+          if(item.get_local_id(0) == 0)
+            digit_totals[item.get_group(0)] = offsets[row + num_groups - 1] + counts[row + num_groups - 1];
+        });
+    }); // submit
+  }
+
+  sycl::event submit_scatter(int pass, int src)
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto keys_in = _keys_buff[src].template get_access<mode::read>(cgh);
+      auto keys_out = _keys_buff[1 - src].template get_access<mode::discard_write>(cgh);
+      auto values_in = _values_buff[src].template get_access<mode::read>(cgh);
+      auto values_out = _values_buff[1 - src].template get_access<mode::discard_write>(cgh);
+      auto offsets = _offsets_buff.template get_access<mode::read>(cgh);
+      auto digit_totals = _digit_totals_buff.template get_access<mode::read>(cgh);
+      // Output position of the next key of every digit
+      auto digit_offsets = sycl::accessor<int, 1, mode::read_write, target::local>{RADIX, cgh};
+
+      const std::size_t n = _args.problem_size;
+      const std::size_t num_groups = _num_groups;
+
+      cgh.parallel_for<RadixSortKernelScatter<KeyT, WithPayload, Distribution>>(
+        get_nd_range(),
+        [=](sycl::nd_item<1> item) {
+          auto grp = item.get_group();
+          const int lid = item.get_local_id(0);
+          const int group_size = item.get_local_range(0);
+          const std::size_t group = item.get_group(0);
+          const std::size_t tile_begin = group * ITEMS_PER_WORK_ITEM * group_size;
+
+          if(lid == 0) {
+            int digit_base = 0;
+            for(int b = 0; b < RADIX; ++b) {
+              digit_offsets[b] = digit_base + offsets[b * num_groups + group];
+              digit_base += digit_totals[b];
+            }
+          }
+
+          for(int c = 0; c < ITEMS_PER_WORK_ITEM; ++c) {
+            item.barrier(fence_space::local_space);
+
+            const std::size_t i = tile_begin + c * group_size + lid;
+            const int digit = (i < n) ? get_digit(keys_in[i], pass) : RADIX;
+
+            // The rank among the keys of the chunk with the same digit keeps the sort stable
+            int rank = 0;
+            int chunk_counts[RADIX];
+            for(int b = 0; b < RADIX; ++b) {
+              const int match = (digit == b) ? 1 : 0;
+              const int preceding = sycl::exclusive_scan_over_group(grp, match, sycl::plus<int>());
+              if(match)
+                rank = preceding;
+              chunk_counts[b] = sycl::group_broadcast(grp, preceding + match, group_size - 1);
+            }
+
+            if(i < n) {
+              const int position = digit_offsets[digit] + rank;
+              keys_out[position] = keys_in[i];
+              if(WithPayload)
+                values_out[position] = values_in[i];
+            }
+
+            item.barrier(fence_space::local_space);
+            if(lid == 0) {
+              for(int b = 0; b < RADIX; ++b)
+                digit_offsets[b] += chunk_counts[b];
+            }
+          }
+        });
+    }); // submit
+  }
+};
+
+template<class KeyT, bool WithPayload>
+void runDistributions(BenchmarkApp& app)
+{
+  app.run<RadixSort<KeyT, WithPayload, KeyDistribution::Uniform>>();
+  app.run<RadixSort<KeyT, WithPayload, KeyDistribution::Sorted>>();
+  app.run<RadixSort<KeyT, WithPayload, KeyDistribution::LowEntropy>>();
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  if(app.shouldRunNDRangeKernels()) {
+    runDistributions<unsigned int, false>(app);
+    runDistributions<unsigned int, true>(app);
+    runDistributions<unsigned long long, false>(app);
+    runDistributions<unsigned long long, true>(app);
+  }
+
+  return 0;
+}
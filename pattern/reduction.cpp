@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <vector>
 #include <cassert>
@@ -239,6 +240,379 @@ public:
   }
 };
 
+// Maximum number of work groups of the grid-stride and single-pass variants.
+// Every work item accumulates problem_size / (GRID_STRIDE_MAX_GROUPS * local_size) elements.
+constexpr std::size_t GRID_STRIDE_MAX_GROUPS = 256;
+
+enum class ReductionOp { Sum, Min, Max, MinMax };
+
+// How the reduction is implemented:
+//  * SYCLReduction: a basic parallel_for with the SYCL 2020 reduction interface.
+//  * GridStride: a fixed number of work groups, every work item accumulates many elements
+//    before a tree reduction in local memory. A second kernel reduces the partial results.
+//  * SinglePassAtomic: like GridStride, but with reduce_over_group, and the partial results of
+//    the work groups are combined with atomics in the same kernel.
+//  * ReduceOverGroup: one element per work item and reduce_over_group, in multiple passes.
+enum class ReductionVariant { SYCLReduction, GridStride, SinglePassAtomic, ReduceOverGroup };
+
+// Result of the custom reduction: minimum and maximum of all elements
+template <typename T>
+struct MinMax
+{
+  T min;
+  T max;
+};
+
+template <typename T>
+struct MinMaxCombine
+{
+  MinMax<T> operator()(const MinMax<T>& a, const MinMax<T>& b) const {
+    return {b.min < a.min ? b.min : a.min, a.max < b.max ? b.max : a.max};
+  }
+};
+
+template <typename T, ReductionOp Op>
+struct ReductionOpTraits;
+
+template <typename T>
+using GlobalAtomicRef = sycl::atomic_ref<T, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                                         sycl::access::address_space::global_space>;
+
+template <typename T>
+struct ReductionOpTraits<T, ReductionOp::Sum>
+{
+  using result_type = T;
+  using operation = sycl::plus<T>;
+  static std::string name() { return "Sum"; }
+  static result_type identity() { return T{0}; }
+  static result_type from_element(T x) { return x; }
+  template <class Group>
+  static result_type group_reduce(const Group& g, result_type x) { return sycl::reduce_over_group(g, x, operation{}); }
+  static void atomic_combine(result_type& target, result_type x) { GlobalAtomicRef<T>{target}.fetch_add(x); }
+};
+
+template <typename T>
+struct ReductionOpTraits<T, ReductionOp::Min>
+{
+  using result_type = T;
+  using operation = sycl::minimum<T>;
+  static std::string name() { return "Min"; }
+  static result_type identity() { return std::numeric_limits<T>::max(); }
+  static result_type from_element(T x) { return x; }
+  template <class Group>
+  static result_type group_reduce(const Group& g, result_type x) { return sycl::reduce_over_group(g, x, operation{}); }
+  static void atomic_combine(result_type& target, result_type x) { GlobalAtomicRef<T>{target}.fetch_min(x); }
+};
+
+template <typename T>
+struct ReductionOpTraits<T, ReductionOp::Max>
+{
+  using result_type = T;
+  using operation = sycl::maximum<T>;
+  static std::string name() { return "Max"; }
+  static result_type identity() { return std::numeric_limits<T>::lowest(); }
+  static result_type from_element(T x) { return x; }
+  template <class Group>
+  static result_type group_reduce(const Group& g, result_type x) { return sycl::reduce_over_group(g, x, operation{}); }
+  static void atomic_combine(result_type& target, result_type x) { GlobalAtomicRef<T>{target}.fetch_max(x); }
+};
+
+// Group algorithms and atomics only support the SYCL function objects and scalar types,
+// so they are applied to both members separately.
+template <typename T>
+struct ReductionOpTraits<T, ReductionOp::MinMax>
+{
+  using result_type = MinMax<T>;
+  using operation = MinMaxCombine<T>;
+  static std::string name() { return "MinMax"; }
+  static result_type identity() { return {std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest()}; }
+  static result_type from_element(T x) { return {x, x}; }
+  template <class Group>
+  static result_type group_reduce(const Group& g, result_type x) {
+    return {sycl::reduce_over_group(g, x.min, sycl::minimum<T>()), sycl::reduce_over_group(g, x.max, sycl::maximum<T>())};
+  }
+  static void atomic_combine(result_type& target, result_type x) {
+    GlobalAtomicRef<T>{target.min}.fetch_min(x.min);
+    GlobalAtomicRef<T>{target.max}.fetch_max(x.max);
+  }
+};
+
+template <typename T, ReductionOp Op, ReductionVariant Variant, int Pass> class ReductionVariantKernel;
+
+template <typename T, ReductionOp Op, ReductionVariant Variant>
+class ReductionVariants
+{
+  using Traits = ReductionOpTraits<T, Op>;
+  using R = typename Traits::result_type;
+
+protected:
+    std::vector<T> _input;
+    std::vector<R> _output_init;
+    BenchmarkArgs _args;
+
+    std::size_t _num_groups;
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<R, 1> _output_buff;
+    PrefetchedBuffer<R, 1> _partials_buff;
+    PrefetchedBuffer<R, 1> _partials_swap_buff;
+    sycl::buffer<R, 1>* _final_output_buff;
+public:
+  ReductionVariants(const BenchmarkArgs &args)
+    : _args{args}
+  {}
+
+  void generate_input(std::vector<T>& out)
+  {
+    out.resize(_args.problem_size);
+    for(std::size_t i = 0; i < out.size(); ++i)
+      out[i] = static_cast<T>((i * 7919) % 1021);
+  }
+
+  void setup() {
+    generate_input(_input);
+
+    _num_groups = (_args.problem_size + _args.local_size - 1) / _args.local_size;
+    if(Variant == ReductionVariant::GridStride || Variant == ReductionVariant::SinglePassAtomic)
+      _num_groups = std::min(_num_groups, GRID_STRIDE_MAX_GROUPS);
+
+    _input_buff.initialize(_args.device_queue, static_cast<const T*>(_input.data()), sycl::range<1>(_args.problem_size));
+
+    // The atomics combine into the initial value
+    _output_init.assign(1, Traits::identity());
+    _output_buff.initialize(_args.device_queue, _output_init.data(), sycl::range<1>{1});
+    _final_output_buff = &_output_buff.get();
+
+    if(Variant == ReductionVariant::GridStride || Variant == ReductionVariant::ReduceOverGroup)
+      _partials_buff.initialize(_args.device_queue, sycl::range<1>{_num_groups});
+    if(Variant == ReductionVariant::ReduceOverGroup)
+      _partials_swap_buff.initialize(_args.device_queue, sycl::range<1>{_num_groups});
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    // The kernel names only distinguish the variants, so only the kernels of this one may be instantiated
+    if constexpr(Variant == ReductionVariant::SYCLReduction)
+      submit_sycl_reduction(events);
+    else if constexpr(Variant == ReductionVariant::GridStride)
+      submit_grid_stride(events);
+    else if constexpr(Variant == ReductionVariant::SinglePassAtomic)
+      submit_single_pass_atomic(events);
+    else
+      submit_reduce_over_group(events);
+  }
+
+  bool verify(VerificationSetting &ver) {
+    const R result = _final_output_buff->get_host_access()[0];
+
+    if constexpr(Op == ReductionOp::Sum) {
+      // Calculate CPU result in fp64 to avoid obtaining a wrong verification result
+      double expected = 0.0;
+      for(T x : _input)
+        expected += static_cast<double>(x);
+      return std::abs(static_cast<double>(result) - expected) <= 1.e-5 * std::max(1.0, expected);
+    } else if constexpr(Op == ReductionOp::MinMax) {
+      R expected = Traits::identity();
+      for(T x : _input)
+        expected = typename Traits::operation{}(expected, Traits::from_element(x));
+      return result.min == expected.min && result.max == expected.max;
+    } else {
+      R expected = Traits::identity();
+      for(T x : _input)
+        expected = typename Traits::operation{}(expected, Traits::from_element(x));
+      return result == expected;
+    }
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_Reduction_";
+    switch(Variant) {
+    case ReductionVariant::SYCLReduction: name << "SYCLReduction_"; break;
+    case ReductionVariant::GridStride: name << "GridStride_"; break;
+    case ReductionVariant::SinglePassAtomic: name << "SinglePassAtomic_"; break;
+    case ReductionVariant::ReduceOverGroup: name << "ReduceOverGroup_"; break;
+    }
+    name << Traits::name() << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+private:
+  // Tree reduction in local memory, the result is only returned to work item 0
+  static R local_tree_reduce(sycl::nd_item<1>& item,
+                             const sycl::accessor<R, 1, sycl::access::mode::read_write, sycl::access::target::local>& scratch,
+                             R value)
+  {
+    const int lid = item.get_local_id(0);
+    const int group_size = item.get_local_range(0);
+
+    scratch[lid] = value;
+    for(int i = group_size/2; i > 0; i /= 2) {
+      item.barrier(sycl::access::fence_space::local_space);
+      if(lid < i)
+        scratch[lid] = typename Traits::operation{}(scratch[lid], scratch[lid + i]);
+    }
+    // Without a final barrier, only work item 0 (which wrote the last step) may read the result
+    return lid == 0 ? scratch[0] : value;
+  }
+
+  void submit_sycl_reduction(std::vector<cl::sycl::event>& events)
+  {
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      auto acc = _input_buff.template get_access<sycl::access::mode::read>(cgh);
+      auto reduction = sycl::reduction(_output_buff.get(), cgh, Traits::identity(), typename Traits::operation{},
+                                       sycl::property_list{sycl::property::reduction::initialize_to_identity{}});
+
+      cgh.parallel_for<ReductionVariantKernel<T, Op, Variant, 0>>(
+        sycl::range<1>{_args.problem_size}, reduction,
+        [=](sycl::id<1> idx, auto& reducer) {
+          reducer.combine(Traits::from_element(acc[idx]));
+        });
+    })); // submit
+  }
+
+  void submit_grid_stride(std::vector<cl::sycl::event>& events)
+  {
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto partials = _partials_buff.template get_access<mode::discard_write>(cgh);
+      auto scratch = sycl::accessor<R, 1, mode::read_write, target::local>{_args.local_size, cgh};
+
+      const std::size_t n = _args.problem_size;
+
+      cgh.parallel_for<ReductionVariantKernel<T, Op, Variant, 0>>(
+        sycl::nd_range<1>{_num_groups * _args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          R value = Traits::identity();
+          for(std::size_t i = item.get_global_id(0); i < n; i += item.get_global_range(0))
+            value = typename Traits::operation{}(value, Traits::from_element(acc[i]));
+
+          value = local_tree_reduce(item, scratch, value);
+          if(item.get_local_id(0) == 0)
+            partials[item.get_group(0)] = value;
+        });
+    })); // submit
+
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto partials = _partials_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+      auto scratch = sycl::accessor<R, 1, mode::read_write, target::local>{_args.local_size, cgh};
+
+      const std::size_t num_partials = _num_groups;
+
+      // A single work group reduces the partial results
+      cgh.parallel_for<ReductionVariantKernel<T, Op, Variant, 1>>(
+        sycl::nd_range<1>{_args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          R value = Traits::identity();
+          for(std::size_t i = item.get_local_id(0); i < num_partials; i += item.get_local_range(0))
+            value = typename Traits::operation{}(value, partials[i]);
+
+          value = local_tree_reduce(item, scratch, value);
+          if(item.get_local_id(0) == 0)
+            acc_out[0] = value;
+        });
+    })); // submit
+  }
+
+  void submit_single_pass_atomic(std::vector<cl::sycl::event>& events)
+  {
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::read_write>(cgh);
+
+      const std::size_t n = _args.problem_size;
+
+      cgh.parallel_for<ReductionVariantKernel<T, Op, Variant, 0>>(
+        sycl::nd_range<1>{_num_groups * _args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          R value = Traits::identity();
+          for(std::size_t i = item.get_global_id(0); i < n; i += item.get_global_range(0))
+            value = typename Traits::operation{}(value, Traits::from_element(acc[i]));
+
+          value = Traits::group_reduce(item.get_group(), value);
+          if(item.get_local_id(0) == 0)
+            Traits::atomic_combine(acc_out[0], value);
+        });
+    })); // submit
+  }
+
+  void submit_reduce_over_group(std::vector<cl::sycl::event>& events)
+  {
+    std::size_t current_size = _args.problem_size;
+    sycl::buffer<R, 1>* output = &_partials_buff.get();
+    sycl::buffer<R, 1>* swap = &_partials_swap_buff.get();
+
+    // The first pass reads the input elements, all further passes the partial results
+    events.push_back(reduce_over_group_pass<0>(_input_buff.get(), *output, current_size));
+    current_size = (current_size + _args.local_size - 1) / _args.local_size;
+
+    while(current_size > 1) {
+      std::swap(output, swap);
+      events.push_back(reduce_over_group_pass<1>(*swap, *output, current_size));
+      current_size = (current_size + _args.local_size - 1) / _args.local_size;
+    }
+    _final_output_buff = output;
+  }
+
+  template<int Pass, class InputT>
+  sycl::event reduce_over_group_pass(sycl::buffer<InputT, 1>& input, sycl::buffer<R, 1>& output,
+                                     const std::size_t reduction_size)
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = input.template get_access<mode::read>(cgh);
+      auto acc_out = output.template get_access<mode::discard_write>(cgh);
+
+      const std::size_t num_groups = (reduction_size + _args.local_size - 1) / _args.local_size;
+
+      cgh.parallel_for<ReductionVariantKernel<T, Op, Variant, Pass>>(
+        sycl::nd_range<1>{num_groups * _args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          const std::size_t gid = item.get_global_id(0);
+
+          R value = Traits::identity();
+          if(gid < reduction_size) {
+            if constexpr(Pass == 0)
+              value = Traits::from_element(acc[gid]);
+            else
+              value = acc[gid];
+          }
+
+          value = Traits::group_reduce(item.get_group(), value);
+          if(item.get_local_id(0) == 0)
+            acc_out[item.get_group(0)] = value;
+        });
+    }); // submit
+  }
+};
+
+template<class T, ReductionVariant Variant>
+void runReductionOps(BenchmarkApp& app)
+{
+  app.run<ReductionVariants<T, ReductionOp::Sum, Variant>>();
+  app.run<ReductionVariants<T, ReductionOp::Min, Variant>>();
+  app.run<ReductionVariants<T, ReductionOp::Max, Variant>>();
+  app.run<ReductionVariants<T, ReductionOp::MinMax, Variant>>();
+}
+
+template<class T>
+void runReductionVariants(BenchmarkApp& app)
+{
+  runReductionOps<T, ReductionVariant::SYCLReduction>(app);
+  if(app.shouldRunNDRangeKernels()) {
+    runReductionOps<T, ReductionVariant::GridStride>(app);
+    runReductionOps<T, ReductionVariant::SinglePassAtomic>(app);
+    runReductionOps<T, ReductionVariant::ReduceOverGroup>(app);
+  }
+}
+
 int main(int argc, char** argv)
 {
   BenchmarkApp app(argc, argv);
@@ -260,6 +634,9 @@ int main(int argc, char** argv)
   if(app.deviceSupportsFP64())
     app.run<ReductionHierarchical<double>>();
 
+  runReductionVariants<int>(app);
+  runReductionVariants<float>(app);
+
   return 0;
 }
 
@@ -1 +1,584 @@
-TODO: SYCL code with a scan
+#include "common.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+using namespace cl;
+
+enum class ScanKind { Exclusive, Inclusive };
+
+// Number of elements per work item of the joint_exclusive_scan variant
+constexpr std::size_t JOINT_SCAN_ITEMS_PER_WORK_ITEM = 8;
+
+// Status of a tile in the decoupled look-back scan
+constexpr int TILE_STATUS_INVALID = 0;
+constexpr int TILE_STATUS_AGGREGATE = 1;
+constexpr int TILE_STATUS_PREFIX = 2;
+
+template <typename T, ScanKind Kind> class ScanKernelBlellochNDRange;
+template <typename T, ScanKind Kind> class ScanKernelBlellochHierarchical;
+template <typename T, ScanKind Kind> class ScanKernelJoint;
+template <typename T, ScanKind Kind, class Variant> class ScanKernelAddBlockSums;
+template <typename T, ScanKind Kind> class ScanKernelDecoupledLookback;
+
+template <typename T, ScanKind Kind>
+class Scan
+{
+protected:
+    std::vector<T> _input;
+    BenchmarkArgs _args;
+    // Number of elements scanned by one work group
+    std::size_t _tile_size;
+
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<T, 1> _output_buff;
+
+    // Sizes of the levels of the multi-level scan, level 0 is the input
+    std::vector<std::size_t> _level_sizes;
+    // Per level > 0: the block sums of the previous level, and their exclusive scan
+    std::vector<PrefetchedBuffer<T, 1>> _block_sums_buff;
+    std::vector<PrefetchedBuffer<T, 1>> _scanned_sums_buff;
+    PrefetchedBuffer<T, 1> _total_buff;
+public:
+  Scan(const BenchmarkArgs &args, std::size_t tile_size)
+    : _args{args}, _tile_size{tile_size}
+  {
+    assert(_args.local_size > 0 && (_args.local_size & (_args.local_size - 1)) == 0 &&
+           "Local size must be a power of two");
+  }
+
+  void generate_input(std::vector<T>& out)
+  {
+    out.resize(_args.problem_size);
+    // Small values, such that even large scans do not overflow
+    for(std::size_t i = 0; i < out.size(); ++i)
+      out[i] = static_cast<T>(i % 4);
+  }
+
+  void setup() {
+    generate_input(_input);
+
+    _input_buff.initialize(_args.device_queue, static_cast<const T*>(_input.data()), sycl::range<1>(_args.problem_size));
+    _output_buff.initialize(_args.device_queue, sycl::range<1>{_args.problem_size});
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size) / 1.0e9, "Gelem"};
+  }
+
+  bool verify(VerificationSetting &ver) {
+    // Reference in fp64 for floating point types
+    using RefT = std::conditional_t<std::is_floating_point_v<T>, double, T>;
+
+    auto result = _output_buff.template get_access<sycl::access::mode::read>();
+    RefT sum = 0;
+    for(std::size_t i = 0; i < _input.size(); ++i) {
+      if(Kind == ScanKind::Inclusive)
+        sum += static_cast<RefT>(_input[i]);
+
+      if constexpr(std::is_floating_point_v<T>) {
+        // fp32 accumulates rounding errors along the chain of tiles
+        const double tolerance = std::is_same_v<T, float> ? 1.e-3 : 1.e-9;
+        const double delta = std::abs(static_cast<double>(result[i]) - sum);
+        if(delta > tolerance * std::max(1.0, std::abs(sum)))
+          return false;
+      } else {
+        if(result[i] != sum)
+          return false;
+      }
+
+      if(Kind == ScanKind::Exclusive)
+        sum += static_cast<RefT>(_input[i]);
+    }
+    return true;
+  }
+
+  static std::string getKindName() {
+    return Kind == ScanKind::Exclusive ? "Exclusive" : "Inclusive";
+  }
+
+protected:
+  // Allocates the intermediate buffers of the multi-level scan
+  void setup_levels()
+  {
+    _level_sizes = {_args.problem_size};
+    while(_level_sizes.back() > _tile_size)
+      _level_sizes.push_back((_level_sizes.back() + _tile_size - 1) / _tile_size);
+
+    _block_sums_buff.resize(_level_sizes.size());
+    _scanned_sums_buff.resize(_level_sizes.size());
+    for(std::size_t level = 1; level < _level_sizes.size(); ++level) {
+      _block_sums_buff[level].initialize(_args.device_queue, sycl::range<1>{_level_sizes[level]});
+      _scanned_sums_buff[level].initialize(_args.device_queue, sycl::range<1>{_level_sizes[level]});
+    }
+    _total_buff.initialize(_args.device_queue, sycl::range<1>{1});
+  }
+
+  // Scans all levels from the input down to a single work group, then adds
+  // the scanned block sums back to every level on the way up.
+  // block_scan(input, output, scan_size, num_groups, block_sums, inclusive)
+  // scans every tile of the input and writes the total of each tile to block_sums.
+  template<class Variant, class Block_scan_function>
+  void submit_multilevel(std::vector<cl::sycl::event>& events, Block_scan_function block_scan)
+  {
+    const std::size_t num_levels = _level_sizes.size();
+
+    auto level_input = [&](std::size_t level) -> sycl::buffer<T, 1>* {
+      return level == 0 ? &_input_buff.get() : &_block_sums_buff[level].get();
+    };
+    auto level_output = [&](std::size_t level) -> sycl::buffer<T, 1>* {
+      return level == 0 ? &_output_buff.get() : &_scanned_sums_buff[level].get();
+    };
+
+    for(std::size_t level = 0; level < num_levels; ++level) {
+      sycl::buffer<T, 1>* block_sums =
+          level + 1 < num_levels ? &_block_sums_buff[level + 1].get() : &_total_buff.get();
+      const std::size_t num_groups = (_level_sizes[level] + _tile_size - 1) / _tile_size;
+
+      events.push_back(block_scan(level_input(level), level_output(level), _level_sizes[level], num_groups,
+                                  block_sums, level == 0 && Kind == ScanKind::Inclusive));
+    }
+
+    for(std::size_t level = num_levels - 1; level-- > 0;) {
+      events.push_back(add_block_sums<Variant>(level_output(level), &_scanned_sums_buff[level + 1].get(),
+                                               _level_sizes[level]));
+    }
+  }
+
+private:
+  template<class Variant>
+  sycl::event add_block_sums(
+    sycl::buffer<T, 1>* output, sycl::buffer<T, 1>* scanned_sums, const std::size_t scan_size)
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc_out = output->template get_access<mode::read_write>(cgh);
+      auto acc_sums = scanned_sums->template get_access<mode::read>(cgh);
+
+      const std::size_t tile_size = _tile_size;
+
+      cgh.parallel_for<ScanKernelAddBlockSums<T, Kind, Variant>>(
+        sycl::range<1>{scan_size},
+        [=](sycl::id<1> idx) {
+          acc_out[idx] += acc_sums[idx[0] / tile_size];
+        });
+    }); // submit
+  }
+};
+
+// Work-efficient scan after Blelloch: every work group scans local_size elements
+// in local memory with an up-sweep and a down-sweep, the block sums are scanned recursively.
+template<class T, ScanKind Kind>
+class ScanBlellochNDRange : public Scan<T, Kind>
+{
+public:
+  ScanBlellochNDRange(const BenchmarkArgs &args)
+  : Scan<T, Kind>{args, args.local_size}
+  {}
+
+  void setup() {
+    Scan<T, Kind>::setup();
+    this->setup_levels();
+  }
+
+  void run(std::vector<cl::sycl::event>& events){
+    this->template submit_multilevel<ScanBlellochNDRange>(events,
+      [this](sycl::buffer<T, 1>* input, sycl::buffer<T, 1>* output, const std::size_t scan_size,
+             const std::size_t num_groups, sycl::buffer<T, 1>* block_sums, const bool inclusive) {
+        return this->block_scan(input, output, scan_size, num_groups, block_sums, inclusive);
+      });
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_Scan_Blelloch_NDRange_";
+    name << Scan<T, Kind>::getKindName() << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+private:
+  sycl::event block_scan(
+    sycl::buffer<T, 1>* input, sycl::buffer<T, 1>* output, const std::size_t scan_size,
+    const std::size_t num_groups, sycl::buffer<T, 1>* block_sums, const bool inclusive)
+  {
+    return this->_args.device_queue.submit([&](sycl::handler &cgh) {
+
+      sycl::nd_range<1> ndrange{num_groups * this->_args.local_size,
+                                this->_args.local_size};
+
+      using namespace cl::sycl::access;
+
+      auto acc      = input->template get_access<mode::read>(cgh);
+      auto acc_out  = output->template get_access<mode::discard_write>(cgh);
+      auto acc_sums = block_sums->template get_access<mode::discard_write>(cgh);
+      auto scratch  = sycl::accessor<T, 1, mode::read_write, target::local>
+        {this->_args.local_size, cgh};
+
+      const int group_size = this->_args.local_size;
+
+      cgh.parallel_for<ScanKernelBlellochNDRange<T, Kind>>(
+        ndrange,
+        [=](sycl::nd_item<1> item) {
+
+          const int lid = item.get_local_id(0);
+          const auto gid = item.get_global_id();
+
+          const T x = (gid[0] < scan_size) ? acc[gid] : T{0};
+          scratch[lid] = x;
+
+          // Up-sweep: build the reduction tree in place
+          for(int d = 1; d < group_size; d *= 2) {
+            item.barrier(fence_space::local_space);
+            const int i = (lid + 1) * 2 * d - 1;
+            if(i < group_size)
+              scratch[i] += scratch[i - d];
+          }
+
+          item.barrier(fence_space::local_space);
+          if(lid == group_size - 1) {
+            acc_sums[item.get_group(0)] = scratch[lid];
+            scratch[lid] = T{0};
+          }
+
+          // Down-sweep: distribute the partial sums back down the tree
+          for(int d = group_size / 2; d > 0; d /= 2) {
+            item.barrier(fence_space::local_space);
+            const int i = (lid + 1) * 2 * d - 1;
+            if(i < group_size) {
+              const T t = scratch[i - d];
+              scratch[i - d] = scratch[i];
+              scratch[i] += t;
+            }
+          }
+
+          item.barrier(fence_space::local_space);
+          if(gid[0] < scan_size)
+            acc_out[gid] = inclusive ? scratch[lid] + x : scratch[lid];
+        });
+    }); // submit
+  }
+};
+
+template<class T, ScanKind Kind>
+class ScanBlellochHierarchical : public Scan<T, Kind>
+{
+public:
+  ScanBlellochHierarchical(const BenchmarkArgs &args)
+  : Scan<T, Kind>{args, args.local_size}
+  {}
+
+  void setup() {
+    Scan<T, Kind>::setup();
+    this->setup_levels();
+  }
+
+  void run(std::vector<cl::sycl::event>& events){
+    this->template submit_multilevel<ScanBlellochHierarchical>(events,
+      [this](sycl::buffer<T, 1>* input, sycl::buffer<T, 1>* output, const std::size_t scan_size,
+             const std::size_t num_groups, sycl::buffer<T, 1>* block_sums, const bool inclusive) {
+        return this->block_scan(input, output, scan_size, num_groups, block_sums, inclusive);
+      });
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_Scan_Blelloch_Hierarchical_";
+    name << Scan<T, Kind>::getKindName() << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+private:
+  sycl::event block_scan(
+    sycl::buffer<T, 1>* input, sycl::buffer<T, 1>* output, const std::size_t scan_size,
+    const std::size_t num_groups, sycl::buffer<T, 1>* block_sums, const bool inclusive)
+  {
+    return this->_args.device_queue.submit(
+        [&](sycl::handler& cgh) {
+
+      using namespace sycl::access;
+
+      auto acc      = input->template get_access<mode::read>(cgh);
+      auto acc_out  = output->template get_access<mode::discard_write>(cgh);
+      auto acc_sums = block_sums->template get_access<mode::discard_write>(cgh);
+
+      auto scratch = sycl::accessor<T, 1, mode::read_write, target::local>
+        {this->_args.local_size, cgh};
+      // The input values, kept for the inclusive scan
+      auto values = sycl::accessor<T, 1, mode::read_write, target::local>
+        {this->_args.local_size, cgh};
+
+      const int group_size = this->_args.local_size;
+
+      cgh.parallel_for_work_group<ScanKernelBlellochHierarchical<T, Kind>>(
+        sycl::range<1>{num_groups},
+        sycl::range<1>{this->_args.local_size},
+        [=](sycl::group<1> grp) {
+
+          grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+            const int lid = idx.get_local_id(0);
+            const auto gid = idx.get_global_id();
+
+            values[lid] = (gid[0] < scan_size) ? acc[gid] : T{0};
+            scratch[lid] = values[lid];
+          });
+
+          for(int d = 1; d < group_size; d *= 2) {
+            grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+              const int i = (idx.get_local_id(0) + 1) * 2 * d - 1;
+              if(i < group_size)
+                scratch[i] += scratch[i - d];
+            });
+          }
+
+          grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+            if(static_cast<int>(idx.get_local_id(0)) == group_size - 1) {
+              acc_sums[grp.get_id(0)] = scratch[group_size - 1];
+              scratch[group_size - 1] = T{0};
+            }
+          });
+
+          for(int d = group_size / 2; d > 0; d /= 2) {
+            grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+              const int i = (idx.get_local_id(0) + 1) * 2 * d - 1;
+              if(i < group_size) {
+                const T t = scratch[i - d];
+                scratch[i - d] = scratch[i];
+                scratch[i] += t;
+              }
+            });
+          }
+
+          grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+            const int lid = idx.get_local_id(0);
+            const auto gid = idx.get_global_id();
+
+            if(gid[0] < scan_size)
+              acc_out[gid] = inclusive ? scratch[lid] + values[lid] : scratch[lid];
+          });
+        });
+    }); // submit
+  }
+};
+
+// Multi-level scan where every work group scans a tile of
+// JOINT_SCAN_ITEMS_PER_WORK_ITEM * local_size elements with the
+// joint_exclusive_scan / joint_inclusive_scan group algorithms.
+template<class T, ScanKind Kind>
+class ScanJoint : public Scan<T, Kind>
+{
+public:
+  ScanJoint(const BenchmarkArgs &args)
+  : Scan<T, Kind>{args, args.local_size * JOINT_SCAN_ITEMS_PER_WORK_ITEM}
+  {}
+
+  void setup() {
+    Scan<T, Kind>::setup();
+    this->setup_levels();
+  }
+
+  void run(std::vector<cl::sycl::event>& events){
+    this->template submit_multilevel<ScanJoint>(events,
+      [this](sycl::buffer<T, 1>* input, sycl::buffer<T, 1>* output, const std::size_t scan_size,
+             const std::size_t num_groups, sycl::buffer<T, 1>* block_sums, const bool inclusive) {
+        return this->block_scan(input, output, scan_size, num_groups, block_sums, inclusive);
+      });
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_Scan_Joint_";
+    name << Scan<T, Kind>::getKindName() << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+private:
+  sycl::event block_scan(
+    sycl::buffer<T, 1>* input, sycl::buffer<T, 1>* output, const std::size_t scan_size,
+    const std::size_t num_groups, sycl::buffer<T, 1>* block_sums, const bool inclusive)
+  {
+    return this->_args.device_queue.submit([&](sycl::handler &cgh) {
+
+      sycl::nd_range<1> ndrange{num_groups * this->_args.local_size,
+                                this->_args.local_size};
+
+      using namespace cl::sycl::access;
+
+      auto acc      = input->template get_access<mode::read>(cgh);
+      auto acc_out  = output->template get_access<mode::discard_write>(cgh);
+      auto acc_sums = block_sums->template get_access<mode::discard_write>(cgh);
+
+      const std::size_t tile_size = this->_tile_size;
+
+      cgh.parallel_for<ScanKernelJoint<T, Kind>>(
+        ndrange,
+        [=](sycl::nd_item<1> item) {
+          auto grp = item.get_group();
+          const std::size_t begin = item.get_group(0) * tile_size;
+          const std::size_t end = sycl::min(begin + tile_size, scan_size);
+
+          if(inclusive)
+            sycl::joint_inclusive_scan(grp, &acc[begin], &acc[begin] + (end - begin), &acc_out[begin],
+                                       sycl::plus<T>());
+          else
+            sycl::joint_exclusive_scan(grp, &acc[begin], &acc[begin] + (end - begin), &acc_out[begin], T{0},
+                                       sycl::plus<T>());
+
+          sycl::group_barrier(grp);
+          if(item.get_local_id(0) == 0)
+            acc_sums[item.get_group(0)] = inclusive ? acc_out[end - 1] : acc_out[end - 1] + acc[end - 1];
+        });
+    }); // submit
+  }
+};
+
+// Single-pass scan with decoupled look-back after Merrill and Garland:
+// every work group scans its tile, publishes the tile aggregate and then
+// accumulates the aggregates or inclusive prefixes of its predecessors
+// until it finds a predecessor whose inclusive prefix is known.
+// Tiles are assigned in the order in which work groups start
+// via an atomic counter, such that only running or finished work groups are waited for.
+template<class T, ScanKind Kind>
+class ScanDecoupledLookback : public Scan<T, Kind>
+{
+  std::vector<int> _tile_status;
+  std::vector<int> _tile_counter;
+
+  PrefetchedBuffer<int, 1> _tile_status_buff;
+  PrefetchedBuffer<int, 1> _tile_counter_buff;
+  PrefetchedBuffer<T, 1> _tile_aggregate_buff;
+  PrefetchedBuffer<T, 1> _tile_prefix_buff;
+public:
+  ScanDecoupledLookback(const BenchmarkArgs &args)
+  : Scan<T, Kind>{args, args.local_size}
+  {}
+
+  void setup() {
+    Scan<T, Kind>::setup();
+
+    const std::size_t num_tiles = (this->_args.problem_size + this->_tile_size - 1) / this->_tile_size;
+    _tile_status.assign(num_tiles, TILE_STATUS_INVALID);
+    _tile_counter.assign(1, 0);
+
+    _tile_status_buff.initialize(this->_args.device_queue, _tile_status.data(), sycl::range<1>{num_tiles});
+    _tile_counter_buff.initialize(this->_args.device_queue, _tile_counter.data(), sycl::range<1>{1});
+    _tile_aggregate_buff.initialize(this->_args.device_queue, sycl::range<1>{num_tiles});
+    _tile_prefix_buff.initialize(this->_args.device_queue, sycl::range<1>{num_tiles});
+  }
+
+  void run(std::vector<cl::sycl::event>& events){
+    events.push_back(this->_args.device_queue.submit([&](sycl::handler &cgh) {
+
+      const std::size_t num_tiles = _tile_status_buff.get_range()[0];
+      sycl::nd_range<1> ndrange{num_tiles * this->_args.local_size,
+                                this->_args.local_size};
+
+      using namespace cl::sycl::access;
+
+      auto acc           = this->_input_buff.template get_access<mode::read>(cgh);
+      auto acc_out       = this->_output_buff.template get_access<mode::discard_write>(cgh);
+      auto tile_status   = _tile_status_buff.template get_access<mode::read_write>(cgh);
+      auto tile_counter  = _tile_counter_buff.template get_access<mode::read_write>(cgh);
+      auto tile_aggregate = _tile_aggregate_buff.template get_access<mode::read_write>(cgh);
+      auto tile_prefix   = _tile_prefix_buff.template get_access<mode::read_write>(cgh);
+
+      const std::size_t scan_size = this->_args.problem_size;
+      const std::size_t tile_size = this->_tile_size;
+
+      cgh.parallel_for<ScanKernelDecoupledLookback<T, Kind>>(
+        ndrange,
+        [=](sycl::nd_item<1> item) {
+          using status_ref = sycl::atomic_ref<int, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                                              address_space::global_space>;
+
+          auto grp = item.get_group();
+          const std::size_t lid = item.get_local_id(0);
+
+          std::size_t ticket = 0;
+          if(lid == 0)
+            ticket = status_ref{tile_counter[0]}.fetch_add(1);
+          const std::size_t tile = sycl::group_broadcast(grp, ticket, 0);
+
+          const std::size_t gid = tile * tile_size + lid;
+          const T x = (gid < scan_size) ? acc[gid] : T{0};
+
+          const T local_scan = (Kind == ScanKind::Inclusive)
+                                   ? sycl::inclusive_scan_over_group(grp, x, sycl::plus<T>())
+                                   : sycl::exclusive_scan_over_group(grp, x, sycl::plus<T>());
+          const T aggregate = sycl::reduce_over_group(grp, x, sycl::plus<T>());
+
+          T exclusive_prefix = T{0};
+          if(lid == 0) {
+            if(tile > 0) {
+              tile_aggregate[tile] = aggregate;
+              status_ref{tile_status[tile]}.store(TILE_STATUS_AGGREGATE, sycl::memory_order::release);
+
+              for(std::size_t predecessor = tile - 1;; --predecessor) {
+                int status;
+                do {
+                  status = status_ref{tile_status[predecessor]}.load(sycl::memory_order::acquire);
+                } while(status == TILE_STATUS_INVALID);
+
+                if(status == TILE_STATUS_PREFIX) {
+                  exclusive_prefix += tile_prefix[predecessor];
+                  break;
+                }
+                exclusive_prefix += tile_aggregate[predecessor];
+              }
+            }
+            tile_prefix[tile] = exclusive_prefix + aggregate;
+            status_ref{tile_status[tile]}.store(TILE_STATUS_PREFIX, sycl::memory_order::release);
+          }
+          exclusive_prefix = sycl::group_broadcast(grp, exclusive_prefix, 0);
+
+          if(gid < scan_size)
+            acc_out[gid] = exclusive_prefix + local_scan;
+        });
+    })); // submit
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_Scan_DecoupledLookback_";
+    name << Scan<T, Kind>::getKindName() << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+};
+
+template<class T, ScanKind Kind>
+void runScans(BenchmarkApp& app)
+{
+  if(app.shouldRunNDRangeKernels()) {
+    app.run<ScanBlellochNDRange<T, Kind>>();
+    app.run<ScanJoint<T, Kind>>();
+    app.run<ScanDecoupledLookback<T, Kind>>();
+  }
+  app.run<ScanBlellochHierarchical<T, Kind>>();
+}
+
+template<class T>
+void runScanKinds(BenchmarkApp& app)
+{
+  runScans<T, ScanKind::Exclusive>(app);
+  runScans<T, ScanKind::Inclusive>(app);
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  runScanKinds<int>(app);
+  runScanKinds<long long>(app);
+  runScanKinds<float>(app);
+  if(app.deviceSupportsFP64())
+    runScanKinds<double>(app);
+
+  return 0;
+}
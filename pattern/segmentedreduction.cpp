@@ -1,6 +1,9 @@
 
 #include "common.h"
+#include "segment_lengths.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <vector>
 #include <cassert>
@@ -192,6 +195,254 @@ public:
   }
 };
 
+// Mean number of elements per segment of the variable-length segmented reduction
+constexpr std::size_t MEAN_SEGMENT_LENGTH = 64;
+// Number of merge path items (elements and segment ends) consumed by one work item
+constexpr std::size_t MERGE_PATH_ITEMS_PER_WORK_ITEM = 8;
+
+// How the work is distributed for segments of variable length:
+//  * ThreadPerSegment: one work item reduces a whole segment.
+//  * GroupPerSegment: one work group reduces a segment, followed by reduce_over_group.
+//  * MergePath: every work item consumes the same number of elements and segment ends
+//    (merge-based load balancing after Merrill and Garland). Partial sums of segments
+//    spanning several work items are combined atomically in a second kernel.
+enum class SegmentStrategy { ThreadPerSegment, GroupPerSegment, MergePath };
+
+template <typename T, SegmentStrategy Strategy, SegmentDistribution Distribution> class VariableSegmentKernel;
+template <typename T, SegmentStrategy Strategy, SegmentDistribution Distribution> class VariableSegmentKernelCarries;
+
+// Reduces segments of variable length, given as CSR offsets, to one sum per segment.
+template <typename T, SegmentStrategy Strategy, SegmentDistribution Distribution>
+class VariableSegmentedReduction
+{
+protected:
+    std::vector<T> _input;
+    std::vector<int> _offsets;
+    BenchmarkArgs _args;
+
+    std::size_t _num_segments;
+    std::size_t _num_merge_path_items;
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<int, 1> _offsets_buff;
+    PrefetchedBuffer<T, 1> _output_buff;
+    // Per work item of the merge path strategy: the segment and the sum it ends with
+    PrefetchedBuffer<int, 1> _carry_segments_buff;
+    PrefetchedBuffer<T, 1> _carry_values_buff;
+public:
+  VariableSegmentedReduction(const BenchmarkArgs &args)
+      : _args{args}
+  {}
+
+  void generate_input(std::vector<T>& out)
+  {
+    out.resize(_args.problem_size);
+    for(std::size_t i = 0; i < out.size(); ++i)
+      out[i] = static_cast<T>(i % 4);
+  }
+
+  void setup() {
+    generate_input(_input);
+
+    const auto offsets = generateSegmentOffsets(Distribution, _args.problem_size, MEAN_SEGMENT_LENGTH);
+    _offsets.assign(offsets.begin(), offsets.end());
+    _num_segments = _offsets.size() - 1;
+
+    _input_buff.initialize(_args.device_queue, _input.data(), sycl::range<1>(_args.problem_size));
+    _offsets_buff.initialize(_args.device_queue, _offsets.data(), sycl::range<1>(_offsets.size()));
+    _output_buff.initialize(_args.device_queue, sycl::range<1>(_num_segments));
+
+    if(Strategy == SegmentStrategy::MergePath) {
+      const std::size_t merge_path_length = _args.problem_size + _num_segments;
+      _num_merge_path_items =
+          (merge_path_length + MERGE_PATH_ITEMS_PER_WORK_ITEM - 1) / MERGE_PATH_ITEMS_PER_WORK_ITEM;
+      _carry_segments_buff.initialize(_args.device_queue, sycl::range<1>(_num_merge_path_items));
+      _carry_values_buff.initialize(_args.device_queue, sycl::range<1>(_num_merge_path_items));
+    }
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    if constexpr(Strategy == SegmentStrategy::ThreadPerSegment)
+      events.push_back(submit_thread_per_segment());
+    else if constexpr(Strategy == SegmentStrategy::GroupPerSegment)
+      events.push_back(submit_group_per_segment());
+    else {
+      events.push_back(submit_merge_path());
+      events.push_back(submit_merge_path_carries());
+    }
+  }
+
+  bool verify(VerificationSetting &ver) {
+    auto acc = _output_buff.template get_access<sycl::access::mode::read>();
+
+    for(std::size_t s = 0; s < _num_segments; ++s) {
+      double sum = 0;
+      for(int i = _offsets[s]; i < _offsets[s + 1]; ++i)
+        sum += static_cast<double>(_input[i]);
+
+      if(std::abs(static_cast<double>(acc[s]) - sum) > 1.e-5 * std::max(1.0, sum))
+        return false;
+    }
+    return true;
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size) / 1.0e9, "Gelem"};
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_SegmentedReduction_";
+    switch(Strategy) {
+    case SegmentStrategy::ThreadPerSegment: name << "ThreadPerSegment_"; break;
+    case SegmentStrategy::GroupPerSegment: name << "GroupPerSegment_"; break;
+    case SegmentStrategy::MergePath: name << "MergePath_"; break;
+    }
+    name << getSegmentDistributionName(Distribution) << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+private:
+  sycl::event submit_thread_per_segment()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto offsets = _offsets_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+
+      cgh.parallel_for<VariableSegmentKernel<T, Strategy, Distribution>>(
+        sycl::range<1>{_num_segments},
+        [=](sycl::id<1> segment) {
+          T sum = 0;
+          for(int i = offsets[segment]; i < offsets[segment[0] + 1]; ++i)
+            sum += acc[i];
+          acc_out[segment] = sum;
+        });
+    }); // submit
+  }
+
+  sycl::event submit_group_per_segment()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto offsets = _offsets_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+
+      const int group_size = _args.local_size;
+
+      cgh.parallel_for<VariableSegmentKernel<T, Strategy, Distribution>>(
+        sycl::nd_range<1>{_num_segments * _args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          const std::size_t segment = item.get_group(0);
+          const int lid = item.get_local_id(0);
+
+          T sum = 0;
+          for(int i = offsets[segment] + lid; i < offsets[segment + 1]; i += group_size)
+            sum += acc[i];
+
+          sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<T>());
+          if(lid == 0)
+            acc_out[segment] = sum;
+        });
+    }); // submit
+  }
+
+  sycl::event submit_merge_path()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc = _input_buff.template get_access<mode::read>(cgh);
+      auto offsets = _offsets_buff.template get_access<mode::read>(cgh);
+      auto acc_out = _output_buff.template get_access<mode::discard_write>(cgh);
+      auto carry_segments = _carry_segments_buff.template get_access<mode::discard_write>(cgh);
+      auto carry_values = _carry_values_buff.template get_access<mode::discard_write>(cgh);
+
+      const int num_segments = _num_segments;
+      const int num_elements = _args.problem_size;
+
+      cgh.parallel_for<VariableSegmentKernel<T, Strategy, Distribution>>(
+        sycl::range<1>{_num_merge_path_items},
+        [=](sycl::id<1> idx) {
+          // The merge path merges the segment ends offsets[1..num_segments] with the element indices.
+          // Find where the diagonal of this work item crosses it.
+          const int diagonal = sycl::min<int>(idx[0] * MERGE_PATH_ITEMS_PER_WORK_ITEM, num_segments + num_elements);
+          int segment_min = sycl::max(diagonal - num_elements, 0);
+          int segment_max = sycl::min(diagonal, num_segments);
+          while(segment_min < segment_max) {
+            const int pivot = (segment_min + segment_max) / 2;
+            if(offsets[pivot + 1] <= diagonal - pivot - 1)
+              segment_min = pivot + 1;
+            else
+              segment_max = pivot;
+          }
+
+          int segment = segment_min;
+          int element = diagonal - segment_min;
+
+          T sum = 0;
+          for(std::size_t k = 0; k < MERGE_PATH_ITEMS_PER_WORK_ITEM && segment < num_segments; ++k) {
+            if(element < offsets[segment + 1]) {
+              sum += acc[element];
+              ++element;
+            } else {
+              // This work item completes the segment. Sums of previous work items are added later.
+              acc_out[segment] = sum;
+              sum = 0;
+              ++segment;
+            }
+          }
+
+          carry_segments[idx] = segment;
+          carry_values[idx] = sum;
+        });
+    }); // submit
+  }
+
+  sycl::event submit_merge_path_carries()
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc_out = _output_buff.template get_access<mode::read_write>(cgh);
+      auto carry_segments = _carry_segments_buff.template get_access<mode::read>(cgh);
+      auto carry_values = _carry_values_buff.template get_access<mode::read>(cgh);
+
+      const int num_segments = _num_segments;
+
+      cgh.parallel_for<VariableSegmentKernelCarries<T, Strategy, Distribution>>(
+        sycl::range<1>{_num_merge_path_items},
+        [=](sycl::id<1> idx) {
+          const int segment = carry_segments[idx];
+          if(segment < num_segments)
+            sycl::atomic_ref<T, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                             address_space::global_space>{acc_out[segment]}.fetch_add(carry_values[idx]);
+        });
+    }); // submit
+  }
+};
+
+template<class T, SegmentStrategy Strategy>
+void runDistributions(BenchmarkApp& app)
+{
+  app.run<VariableSegmentedReduction<T, Strategy, SegmentDistribution::Uniform>>();
+  app.run<VariableSegmentedReduction<T, Strategy, SegmentDistribution::Exponential>>();
+  app.run<VariableSegmentedReduction<T, Strategy, SegmentDistribution::PowerLaw>>();
+}
+
+template<class T>
+void runStrategies(BenchmarkApp& app)
+{
+  runDistributions<T, SegmentStrategy::ThreadPerSegment>(app);
+  if(app.shouldRunNDRangeKernels())
+    runDistributions<T, SegmentStrategy::GroupPerSegment>(app);
+  runDistributions<T, SegmentStrategy::MergePath>(app);
+}
+
 int main(int argc, char** argv)
 {
   BenchmarkApp app(argc, argv);
@@ -212,6 +463,9 @@ int main(int argc, char** argv)
   if(app.deviceSupportsFP64())
     app.run<SegmentedReductionHierarchical<double>>();
 
+  runStrategies<int>(app);
+  runStrategies<float>(app);
+
   return 0;
 }
 
@@ -1 +1,473 @@
-TODO: SYCL code with segmented scan
+#include "common.h"
+#include "segment_lengths.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+using namespace cl;
+
+// Mean number of elements per segment
+constexpr std::size_t MEAN_SEGMENT_LENGTH = 64;
+
+// How the segments are described:
+//  * HeadFlags: one flag per element, set for the first element of every segment.
+//  * Offsets: the start offset of every segment (CSR format). Every work item finds
+//    its segment with a binary search.
+enum class SegmentRepresentation { HeadFlags, Offsets };
+
+template <class Variant, SegmentRepresentation Heads> class SegmentedScanKernelNDRange;
+template <class Variant, SegmentRepresentation Heads> class SegmentedScanKernelHierarchical;
+template <class Variant> class SegmentedScanKernelFixup;
+
+// Returns whether element i is the first element of a segment,
+// given the offsets of num_segments segments.
+template <class OffsetAccessor>
+bool is_segment_head(const OffsetAccessor& offsets, std::size_t num_segments, std::size_t i)
+{
+  // Find the last segment starting at or before i
+  std::size_t first = 0;
+  std::size_t last = num_segments;
+  while(last - first > 1) {
+    const std::size_t mid = first + (last - first) / 2;
+    if(static_cast<std::size_t>(offsets[mid]) <= i)
+      first = mid;
+    else
+      last = mid;
+  }
+  return static_cast<std::size_t>(offsets[first]) == i;
+}
+
+// Segmented inclusive scan. Every work group scans local_size elements in local memory.
+// Per work group, the value of its last element, whether it contains a segment head and the position
+// of its first segment head are written out. The block values are scanned recursively (as segmented scan,
+// with a head for every block containing one), and the scanned values are added to the elements of
+// the next block that precede its first segment head.
+template <typename T, SegmentRepresentation Representation, SegmentDistribution Distribution>
+class SegmentedScan
+{
+protected:
+    std::vector<T> _input;
+    std::vector<int> _head_flags;
+    std::vector<int> _offsets;
+    BenchmarkArgs _args;
+
+    PrefetchedBuffer<T, 1> _input_buff;
+    PrefetchedBuffer<T, 1> _output_buff;
+    PrefetchedBuffer<int, 1> _head_flags_buff;
+    PrefetchedBuffer<int, 1> _offsets_buff;
+
+    // Sizes of the levels of the multi-level scan, level 0 is the input
+    std::vector<std::size_t> _level_sizes;
+    // Per level > 0: the block values, flags and first segment heads of the previous level,
+    // and the segmented scan of the block values
+    std::vector<PrefetchedBuffer<T, 1>> _block_values_buff;
+    std::vector<PrefetchedBuffer<int, 1>> _block_flags_buff;
+    std::vector<PrefetchedBuffer<int, 1>> _block_first_head_buff;
+    std::vector<PrefetchedBuffer<T, 1>> _scanned_values_buff;
+    PrefetchedBuffer<T, 1> _total_value_buff;
+    PrefetchedBuffer<int, 1> _total_flag_buff;
+    PrefetchedBuffer<int, 1> _total_first_head_buff;
+public:
+  SegmentedScan(const BenchmarkArgs &args)
+    : _args{args}
+  {
+    assert(_args.local_size > 0 && (_args.local_size & (_args.local_size - 1)) == 0 &&
+           "Local size must be a power of two");
+  }
+
+  void generate_input(std::vector<T>& out)
+  {
+    out.resize(_args.problem_size);
+    for(std::size_t i = 0; i < out.size(); ++i)
+      out[i] = static_cast<T>(i % 4);
+  }
+
+  void setup() {
+    generate_input(_input);
+
+    const auto offsets = generateSegmentOffsets(Distribution, _args.problem_size, MEAN_SEGMENT_LENGTH);
+    if(Representation == SegmentRepresentation::HeadFlags) {
+      _head_flags.assign(_args.problem_size, 0);
+      for(std::size_t s = 0; s + 1 < offsets.size(); ++s)
+        _head_flags[offsets[s]] = 1;
+      _head_flags_buff.initialize(_args.device_queue, _head_flags.data(), sycl::range<1>{_args.problem_size});
+    } else {
+      _offsets.assign(offsets.begin(), offsets.end());
+      _offsets_buff.initialize(_args.device_queue, _offsets.data(), sycl::range<1>{_offsets.size()});
+    }
+
+    _input_buff.initialize(_args.device_queue, static_cast<const T*>(_input.data()), sycl::range<1>(_args.problem_size));
+    _output_buff.initialize(_args.device_queue, sycl::range<1>{_args.problem_size});
+
+    _level_sizes = {_args.problem_size};
+    while(_level_sizes.back() > _args.local_size)
+      _level_sizes.push_back((_level_sizes.back() + _args.local_size - 1) / _args.local_size);
+
+    const std::size_t num_levels = _level_sizes.size();
+    _block_values_buff.resize(num_levels);
+    _block_flags_buff.resize(num_levels);
+    _block_first_head_buff.resize(num_levels);
+    _scanned_values_buff.resize(num_levels);
+    for(std::size_t level = 1; level < num_levels; ++level) {
+      const sycl::range<1> level_range{_level_sizes[level]};
+      _block_values_buff[level].initialize(_args.device_queue, level_range);
+      _block_flags_buff[level].initialize(_args.device_queue, level_range);
+      _block_first_head_buff[level].initialize(_args.device_queue, level_range);
+      _scanned_values_buff[level].initialize(_args.device_queue, level_range);
+    }
+    _total_value_buff.initialize(_args.device_queue, sycl::range<1>{1});
+    _total_flag_buff.initialize(_args.device_queue, sycl::range<1>{1});
+    _total_first_head_buff.initialize(_args.device_queue, sycl::range<1>{1});
+  }
+
+  static ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) {
+    return {static_cast<double>(args.problem_size) / 1.0e9, "Gelem"};
+  }
+
+  bool verify(VerificationSetting &ver) {
+    std::vector<int> heads = _head_flags;
+    if(Representation == SegmentRepresentation::Offsets) {
+      heads.assign(_args.problem_size, 0);
+      for(std::size_t s = 0; s + 1 < _offsets.size(); ++s)
+        heads[_offsets[s]] = 1;
+    }
+
+    using RefT = std::conditional_t<std::is_floating_point_v<T>, double, T>;
+
+    auto result = _output_buff.template get_access<sycl::access::mode::read>();
+    RefT sum = 0;
+    for(std::size_t i = 0; i < _input.size(); ++i) {
+      sum = heads[i] ? static_cast<RefT>(_input[i]) : sum + static_cast<RefT>(_input[i]);
+
+      if constexpr(std::is_floating_point_v<T>) {
+        const double delta = std::abs(static_cast<double>(result[i]) - sum);
+        if(delta > 1.e-5 * std::max(1.0, std::abs(sum)))
+          return false;
+      } else {
+        if(result[i] != sum)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  static std::string getConfigurationName() {
+    std::stringstream name;
+    name << (Representation == SegmentRepresentation::HeadFlags ? "HeadFlags_" : "Offsets_");
+    name << getSegmentDistributionName(Distribution) << "_";
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+protected:
+  // Buffers of one level of the multi-level scan
+  struct Level
+  {
+    sycl::buffer<T, 1>* values;
+    sycl::buffer<int, 1>* heads;
+    sycl::buffer<T, 1>* output;
+    sycl::buffer<T, 1>* block_values;
+    sycl::buffer<int, 1>* block_flags;
+    sycl::buffer<int, 1>* block_first_head;
+    std::size_t size;
+    std::size_t num_groups;
+  };
+
+  // block_scan(level) scans every block of a level with the level 0 segment representation,
+  // block_scan_flags(level) with head flags.
+  template<class Variant, class Block_scan_function, class Block_scan_flags_function>
+  void submit_multilevel(std::vector<cl::sycl::event>& events,
+                         Block_scan_function block_scan, Block_scan_flags_function block_scan_flags)
+  {
+    const std::size_t num_levels = _level_sizes.size();
+
+    for(std::size_t level = 0; level < num_levels; ++level) {
+      const bool is_top = level + 1 == num_levels;
+
+      Level l;
+      l.values = level == 0 ? &_input_buff.get() : &_block_values_buff[level].get();
+      l.output = level == 0 ? &_output_buff.get() : &_scanned_values_buff[level].get();
+      l.heads = level == 0 ? (Representation == SegmentRepresentation::HeadFlags ? &_head_flags_buff.get()
+                                                                                : &_offsets_buff.get())
+                           : &_block_flags_buff[level].get();
+      l.block_values = is_top ? &_total_value_buff.get() : &_block_values_buff[level + 1].get();
+      l.block_flags = is_top ? &_total_flag_buff.get() : &_block_flags_buff[level + 1].get();
+      l.block_first_head = is_top ? &_total_first_head_buff.get() : &_block_first_head_buff[level + 1].get();
+      l.size = _level_sizes[level];
+      l.num_groups = (l.size + _args.local_size - 1) / _args.local_size;
+
+      if(level == 0)
+        events.push_back(block_scan(l));
+      else
+        events.push_back(block_scan_flags(l));
+    }
+
+    for(std::size_t level = num_levels - 1; level-- > 0;) {
+      sycl::buffer<T, 1>* output = level == 0 ? &_output_buff.get() : &_scanned_values_buff[level].get();
+      events.push_back(fixup<Variant>(output, &_block_first_head_buff[level + 1].get(),
+                                      &_scanned_values_buff[level + 1].get(), _level_sizes[level]));
+    }
+  }
+
+  std::size_t get_num_segments() const {
+    return _offsets.empty() ? 0 : _offsets.size() - 1;
+  }
+
+private:
+  template<class Variant>
+  sycl::event fixup(sycl::buffer<T, 1>* output, sycl::buffer<int, 1>* block_first_head,
+                    sycl::buffer<T, 1>* scanned_values, const std::size_t scan_size)
+  {
+    return _args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto acc_out = output->template get_access<mode::read_write>(cgh);
+      auto first_head = block_first_head->template get_access<mode::read>(cgh);
+      auto carries = scanned_values->template get_access<mode::read>(cgh);
+
+      const std::size_t group_size = _args.local_size;
+
+      cgh.parallel_for<SegmentedScanKernelFixup<Variant>>(
+        sycl::range<1>{scan_size},
+        [=](sycl::id<1> idx) {
+          const std::size_t block = idx[0] / group_size;
+          const int lid = idx[0] % group_size;
+          // The elements before the first segment head continue the segment of the previous block
+          if(block > 0 && lid < first_head[block])
+            acc_out[idx] += carries[block - 1];
+        });
+    }); // submit
+  }
+};
+
+template<class T, SegmentRepresentation Representation, SegmentDistribution Distribution>
+class SegmentedScanNDRange : public SegmentedScan<T, Representation, Distribution>
+{
+  using Base = SegmentedScan<T, Representation, Distribution>;
+  using Level = typename Base::Level;
+public:
+  SegmentedScanNDRange(const BenchmarkArgs &args)
+  : Base{args}
+  {}
+
+  void run(std::vector<cl::sycl::event>& events){
+    this->template submit_multilevel<SegmentedScanNDRange>(events,
+      [this](const Level& l) { return this->template block_scan<Representation>(l); },
+      [this](const Level& l) { return this->template block_scan<SegmentRepresentation::HeadFlags>(l); });
+  }
+
+  static std::string getBenchmarkName() {
+    return "Pattern_SegmentedScan_NDRange_" + Base::getConfigurationName();
+  }
+
+private:
+  template<SegmentRepresentation Heads>
+  sycl::event block_scan(const Level& l)
+  {
+    return this->_args.device_queue.submit([&](sycl::handler &cgh) {
+
+      sycl::nd_range<1> ndrange{l.num_groups * this->_args.local_size,
+                                this->_args.local_size};
+
+      using namespace cl::sycl::access;
+
+      auto acc              = l.values->template get_access<mode::read>(cgh);
+      auto heads            = l.heads->template get_access<mode::read>(cgh);
+      auto acc_out          = l.output->template get_access<mode::discard_write>(cgh);
+      auto block_values     = l.block_values->template get_access<mode::discard_write>(cgh);
+      auto block_flags      = l.block_flags->template get_access<mode::discard_write>(cgh);
+      auto block_first_head = l.block_first_head->template get_access<mode::discard_write>(cgh);
+      auto values  = sycl::accessor<T, 1, mode::read_write, target::local>
+        {this->_args.local_size, cgh};
+      auto flags   = sycl::accessor<int, 1, mode::read_write, target::local>
+        {this->_args.local_size, cgh};
+
+      const int group_size = this->_args.local_size;
+      const std::size_t scan_size = l.size;
+      const std::size_t num_segments = this->get_num_segments();
+
+      cgh.parallel_for<SegmentedScanKernelNDRange<SegmentedScanNDRange, Heads>>(
+        ndrange,
+        [=](sycl::nd_item<1> item) {
+
+          const int lid = item.get_local_id(0);
+          const std::size_t gid = item.get_global_id(0);
+
+          int head = 0;
+          if(gid < scan_size) {
+            if constexpr(Heads == SegmentRepresentation::HeadFlags)
+              head = heads[gid];
+            else
+              head = is_segment_head(heads, num_segments, gid) ? 1 : 0;
+          }
+          values[lid] = (gid < scan_size) ? acc[gid] : T{0};
+          flags[lid] = head;
+
+          // Hillis-Steele scan with the segmented operator
+          for(int d = 1; d < group_size; d *= 2) {
+            item.barrier(fence_space::local_space);
+            T v = values[lid];
+            int f = flags[lid];
+            if(lid >= d) {
+              if(!f)
+                v += values[lid - d];
+              f |= flags[lid - d];
+            }
+            item.barrier(fence_space::local_space);
+            values[lid] = v;
+            flags[lid] = f;
+          }
+
+          item.barrier(fence_space::local_space);
+          if(gid < scan_size)
+            acc_out[gid] = values[lid];
+
+          // The flags are now set from the first segment head onwards
+          const int group = item.get_group(0);
+          if(flags[lid] && (lid == 0 || !flags[lid - 1]))
+            block_first_head[group] = lid;
+          if(lid == group_size - 1) {
+            if(!flags[lid])
+              block_first_head[group] = group_size;
+            block_values[group] = values[lid];
+            block_flags[group] = flags[lid];
+          }
+        });
+    }); // submit
+  }
+};
+
+template<class T, SegmentRepresentation Representation, SegmentDistribution Distribution>
+class SegmentedScanHierarchical : public SegmentedScan<T, Representation, Distribution>
+{
+  using Base = SegmentedScan<T, Representation, Distribution>;
+  using Level = typename Base::Level;
+public:
+  SegmentedScanHierarchical(const BenchmarkArgs &args)
+  : Base{args}
+  {}
+
+  void run(std::vector<cl::sycl::event>& events){
+    this->template submit_multilevel<SegmentedScanHierarchical>(events,
+      [this](const Level& l) { return this->template block_scan<Representation>(l); },
+      [this](const Level& l) { return this->template block_scan<SegmentRepresentation::HeadFlags>(l); });
+  }
+
+  static std::string getBenchmarkName() {
+    return "Pattern_SegmentedScan_Hierarchical_" + Base::getConfigurationName();
+  }
+
+private:
+  template<SegmentRepresentation Heads>
+  sycl::event block_scan(const Level& l)
+  {
+    return this->_args.device_queue.submit(
+        [&](sycl::handler& cgh) {
+
+      using namespace sycl::access;
+
+      auto acc              = l.values->template get_access<mode::read>(cgh);
+      auto heads            = l.heads->template get_access<mode::read>(cgh);
+      auto acc_out          = l.output->template get_access<mode::discard_write>(cgh);
+      auto block_values     = l.block_values->template get_access<mode::discard_write>(cgh);
+      auto block_flags      = l.block_flags->template get_access<mode::discard_write>(cgh);
+      auto block_first_head = l.block_first_head->template get_access<mode::discard_write>(cgh);
+
+      // Double-buffered, since all work items of a phase read before any of them writes
+      auto values = sycl::accessor<T, 1, mode::read_write, target::local>
+        {2 * this->_args.local_size, cgh};
+      auto flags  = sycl::accessor<int, 1, mode::read_write, target::local>
+        {2 * this->_args.local_size, cgh};
+
+      const int group_size = this->_args.local_size;
+      const std::size_t scan_size = l.size;
+      const std::size_t num_segments = this->get_num_segments();
+
+      cgh.parallel_for_work_group<SegmentedScanKernelHierarchical<SegmentedScanHierarchical, Heads>>(
+        sycl::range<1>{l.num_groups},
+        sycl::range<1>{this->_args.local_size},
+        [=](sycl::group<1> grp) {
+
+          grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+            const int lid = idx.get_local_id(0);
+            const std::size_t gid = idx.get_global_id(0);
+
+            int head = 0;
+            if(gid < scan_size) {
+              if constexpr(Heads == SegmentRepresentation::HeadFlags)
+                head = heads[gid];
+              else
+                head = is_segment_head(heads, num_segments, gid) ? 1 : 0;
+            }
+            values[lid] = (gid < scan_size) ? acc[gid] : T{0};
+            flags[lid] = head;
+          });
+
+          int src = 0;
+          for(int d = 1; d < group_size; d *= 2) {
+            const int dst = group_size - src;
+            grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+              const int lid = idx.get_local_id(0);
+
+              T v = values[src + lid];
+              int f = flags[src + lid];
+              if(lid >= d) {
+                if(!f)
+                  v += values[src + lid - d];
+                f |= flags[src + lid - d];
+              }
+              values[dst + lid] = v;
+              flags[dst + lid] = f;
+            });
+            src = dst;
+          }
+
+          grp.parallel_for_work_item([&](sycl::h_item<1> idx){
+            const int lid = idx.get_local_id(0);
+            const std::size_t gid = idx.get_global_id(0);
+
+            if(gid < scan_size)
+              acc_out[gid] = values[src + lid];
+
+            const int group = grp.get_id(0);
+            if(flags[src + lid] && (lid == 0 || !flags[src + lid - 1]))
+              block_first_head[group] = lid;
+            if(lid == group_size - 1) {
+              if(!flags[src + lid])
+                block_first_head[group] = group_size;
+              block_values[group] = values[src + lid];
+              block_flags[group] = flags[src + lid];
+            }
+          });
+        });
+    }); // submit
+  }
+};
+
+template<class T, SegmentRepresentation Representation>
+void runDistributions(BenchmarkApp& app)
+{
+  if(app.shouldRunNDRangeKernels()) {
+    app.run<SegmentedScanNDRange<T, Representation, SegmentDistribution::Uniform>>();
+    app.run<SegmentedScanNDRange<T, Representation, SegmentDistribution::Exponential>>();
+    app.run<SegmentedScanNDRange<T, Representation, SegmentDistribution::PowerLaw>>();
+  }
+  app.run<SegmentedScanHierarchical<T, Representation, SegmentDistribution::Uniform>>();
+  app.run<SegmentedScanHierarchical<T, Representation, SegmentDistribution::Exponential>>();
+  app.run<SegmentedScanHierarchical<T, Representation, SegmentDistribution::PowerLaw>>();
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  runDistributions<int, SegmentRepresentation::HeadFlags>(app);
+  runDistributions<int, SegmentRepresentation::Offsets>(app);
+  runDistributions<float, SegmentRepresentation::HeadFlags>(app);
+  runDistributions<float, SegmentRepresentation::Offsets>(app);
+
+  return 0;
+}
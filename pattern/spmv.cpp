@@ -0,0 +1,413 @@
+#include "common.h"
+#include "segment_lengths.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace cl;
+
+// Mean number of non-zeros per row of the generated matrices
+constexpr std::size_t MEAN_NNZ_PER_ROW = 16;
+// Slice height C and sorting window sigma of the SELL-C-sigma format
+constexpr std::size_t SELL_C = 32;
+constexpr std::size_t SELL_SIGMA = 512;
+// ELLPACK is skipped if padding would store more than this many entries per non-zero
+constexpr std::size_t MAX_ELLPACK_PADDING = 4;
+
+// Sparsity structure of the generated square matrices:
+//  * Banded: MEAN_NNZ_PER_ROW consecutive diagonals around the main diagonal.
+//  * RandomUniform: row lengths uniformly distributed in [1, 2 * MEAN_NNZ_PER_ROW - 1],
+//    with uniformly distributed columns.
+//  * PowerLaw: Pareto distributed row lengths (see segment_lengths.h), as in graphs of social networks,
+//    with uniformly distributed columns.
+enum class MatrixStructure { Banded, RandomUniform, PowerLaw };
+
+// Storage format of the matrix:
+//  * CSRScalar: compressed sparse rows, one work item per row.
+//  * CSRVector: compressed sparse rows, one sub-group per row.
+//  * ELLPACK: all rows padded to the longest row and stored column-major, one work item per row.
+//  * SELLCSigma: rows sorted by length within windows of SELL_SIGMA rows and grouped into slices of SELL_C rows,
+//    each padded to its longest row and stored column-major, one work item per row.
+enum class SpMVFormat { CSRScalar, CSRVector, ELLPACK, SELLCSigma };
+
+// Properties of the matrix in the benchmarked format, filled in during setup.
+struct SpMVStats {
+  // Bytes read and written by one SpMV, including padding and assuming every entry of x is read once
+  std::size_t bytes = 0;
+  // Time to convert the matrix from CSR to the benchmarked format on the host
+  std::chrono::nanoseconds conversion_time{0};
+};
+
+inline std::vector<std::size_t> generateRowLengths(MatrixStructure structure, std::size_t num_rows) {
+  std::vector<std::size_t> lengths(num_rows);
+  if(structure == MatrixStructure::Banded) {
+    const std::size_t half_band = MEAN_NNZ_PER_ROW / 2;
+    for(std::size_t row = 0; row < num_rows; ++row)
+      lengths[row] = std::min(row + half_band, num_rows) - (row > half_band ? row - half_band : 0);
+  } else {
+    const auto offsets = generateSegmentOffsets(structure == MatrixStructure::RandomUniform
+                                                    ? SegmentDistribution::Uniform
+                                                    : SegmentDistribution::PowerLaw,
+                                                num_rows * MEAN_NNZ_PER_ROW, MEAN_NNZ_PER_ROW);
+    for(std::size_t row = 0; row < num_rows; ++row)
+      lengths[row] = row + 1 < offsets.size() ? std::min(offsets[row + 1] - offsets[row], num_rows) : 1;
+  }
+  return lengths;
+}
+
+template <typename T, SpMVFormat Format, MatrixStructure Structure> class SpMVKernel;
+
+// Sparse matrix-vector multiplication y = A * x with a generated square matrix A
+// of problem_size rows, as e.g. in iterative solvers and graph analytics.
+template <typename T, SpMVFormat Format, MatrixStructure Structure>
+class SpMV
+{
+protected:
+    // The matrix in the benchmarked format: row offsets (CSR) or slice offsets (SELL-C-sigma),
+    // column indices, values and the original row of every sorted row (SELL-C-sigma)
+    std::vector<int> _offsets;
+    std::vector<int> _columns;
+    std::vector<T> _values;
+    std::vector<int> _permutation;
+    std::vector<T> _x;
+    std::vector<T> _expected;
+    BenchmarkArgs _args;
+    SpMVStats& _stats;
+
+    std::vector<std::size_t> _row_lengths;
+    std::size_t _nnz;
+    std::size_t _ell_width = 0;
+    std::size_t _rows_per_group;
+    PrefetchedBuffer<int, 1> _offsets_buff;
+    PrefetchedBuffer<int, 1> _columns_buff;
+    PrefetchedBuffer<T, 1> _values_buff;
+    PrefetchedBuffer<int, 1> _permutation_buff;
+    PrefetchedBuffer<T, 1> _x_buff;
+    PrefetchedBuffer<T, 1> _y_buff;
+public:
+  SpMV(const BenchmarkArgs &args, SpMVStats& stats)
+    : _args{args}, _stats{stats}
+  {
+    _row_lengths = generateRowLengths(Structure, _args.problem_size);
+    _nnz = std::accumulate(_row_lengths.begin(), _row_lengths.end(), std::size_t{0});
+    // Row and slice offsets are stored as int
+    assert(_nnz <= static_cast<std::size_t>(std::numeric_limits<int>::max()) && "Too many non-zeros");
+  }
+
+  void generate_csr(std::vector<int>& row_offsets, std::vector<int>& columns, std::vector<T>& values)
+  {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> column_dist{0, static_cast<int>(_args.problem_size) - 1};
+    std::uniform_real_distribution<double> value_dist{0.0, 1.0};
+
+    row_offsets.resize(_args.problem_size + 1);
+    columns.resize(_nnz);
+    values.resize(_nnz);
+
+    row_offsets[0] = 0;
+    for(std::size_t row = 0; row < _args.problem_size; ++row) {
+      const int begin = row_offsets[row];
+      row_offsets[row + 1] = begin + static_cast<int>(_row_lengths[row]);
+
+      if(Structure == MatrixStructure::Banded) {
+        const std::size_t first_column = row > MEAN_NNZ_PER_ROW / 2 ? row - MEAN_NNZ_PER_ROW / 2 : 0;
+        std::iota(columns.begin() + begin, columns.begin() + row_offsets[row + 1], static_cast<int>(first_column));
+      } else {
+        for(int k = begin; k < row_offsets[row + 1]; ++k)
+          columns[k] = column_dist(rng);
+        std::sort(columns.begin() + begin, columns.begin() + row_offsets[row + 1]);
+      }
+      for(int k = begin; k < row_offsets[row + 1]; ++k)
+        values[k] = static_cast<T>(value_dist(rng));
+    }
+  }
+
+  void setup() {
+    const std::size_t num_rows = _args.problem_size;
+
+    std::vector<int> row_offsets;
+    std::vector<int> columns;
+    std::vector<T> values;
+    generate_csr(row_offsets, columns, values);
+
+    std::mt19937 rng{43};
+    std::uniform_real_distribution<double> x_dist{0.0, 1.0};
+    _x.resize(num_rows);
+    for(std::size_t i = 0; i < num_rows; ++i)
+      _x[i] = static_cast<T>(x_dist(rng));
+
+    _expected.assign(num_rows, T{0});
+    for(std::size_t row = 0; row < num_rows; ++row) {
+      for(int k = row_offsets[row]; k < row_offsets[row + 1]; ++k)
+        _expected[row] += values[k] * _x[columns[k]];
+    }
+
+    const auto conversion_start = std::chrono::high_resolution_clock::now();
+    if(Format == SpMVFormat::CSRScalar || Format == SpMVFormat::CSRVector) {
+      _offsets = std::move(row_offsets);
+      _columns = std::move(columns);
+      _values = std::move(values);
+    } else if(Format == SpMVFormat::ELLPACK) {
+      convert_to_ellpack(row_offsets, columns, values);
+    } else {
+      convert_to_sell(row_offsets, columns, values);
+    }
+    _stats.conversion_time = Format == SpMVFormat::CSRScalar || Format == SpMVFormat::CSRVector
+        ? std::chrono::nanoseconds{0}
+        : std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() -
+                                                                conversion_start);
+
+    _stats.bytes = _offsets.size() * sizeof(int) + _columns.size() * sizeof(int) + _values.size() * sizeof(T) +
+                   _permutation.size() * sizeof(int) + 2 * num_rows * sizeof(T);
+
+    // Unused buffers of the format hold a single dummy element
+    if(_offsets.empty())
+      _offsets.assign(1, 0);
+    if(_permutation.empty())
+      _permutation.assign(1, 0);
+
+    // Assign as many rows to a work group of CSRVector as it has sub-groups of the largest size,
+    // work groups with smaller sub-groups process several rows per sub-group
+    const auto sub_group_sizes = _args.device_queue.get_device().get_info<sycl::info::device::sub_group_sizes>();
+    const std::size_t max_sub_group_size = *std::max_element(sub_group_sizes.begin(), sub_group_sizes.end());
+    _rows_per_group = std::max<std::size_t>(_args.local_size / max_sub_group_size, 1);
+
+    _offsets_buff.initialize(_args.device_queue, _offsets.data(), sycl::range<1>(_offsets.size()));
+    _columns_buff.initialize(_args.device_queue, _columns.data(), sycl::range<1>(_columns.size()));
+    _values_buff.initialize(_args.device_queue, _values.data(), sycl::range<1>(_values.size()));
+    _permutation_buff.initialize(_args.device_queue, _permutation.data(), sycl::range<1>(_permutation.size()));
+    _x_buff.initialize(_args.device_queue, _x.data(), sycl::range<1>(num_rows));
+    _y_buff.initialize(_args.device_queue, sycl::range<1>(num_rows));
+  }
+
+  void run(std::vector<cl::sycl::event>& events) {
+    events.push_back(_args.device_queue.submit([&](sycl::handler& cgh) {
+      using namespace cl::sycl::access;
+
+      auto offsets = _offsets_buff.template get_access<mode::read>(cgh);
+      auto columns = _columns_buff.template get_access<mode::read>(cgh);
+      auto values = _values_buff.template get_access<mode::read>(cgh);
+      auto permutation = _permutation_buff.template get_access<mode::read>(cgh);
+      auto x = _x_buff.template get_access<mode::read>(cgh);
+      auto y = _y_buff.template get_access<mode::discard_write>(cgh);
+
+      const std::size_t num_rows = _args.problem_size;
+      const std::size_t ell_width = _ell_width;
+      const std::size_t rows_per_group = Format == SpMVFormat::CSRVector ? _rows_per_group : _args.local_size;
+      const std::size_t num_groups = (num_rows + rows_per_group - 1) / rows_per_group;
+
+      cgh.parallel_for<SpMVKernel<T, Format, Structure>>(
+        sycl::nd_range<1>{num_groups * _args.local_size, _args.local_size},
+        [=](sycl::nd_item<1> item) {
+          const std::size_t gid = item.get_global_id(0);
+
+          if constexpr(Format == SpMVFormat::CSRScalar) {
+            if(gid < num_rows) {
+              T sum{0};
+              for(int k = offsets[gid]; k < offsets[gid + 1]; ++k)
+                sum += values[k] * x[columns[k]];
+              y[gid] = sum;
+            }
+          } else if constexpr(Format == SpMVFormat::CSRVector) {
+            auto sg = item.get_sub_group();
+            const int lane = sg.get_local_linear_id();
+            const int sub_group_size = sg.get_local_linear_range();
+            const std::size_t num_sub_groups = item.get_group_range(0) * sg.get_group_linear_range();
+
+            for(std::size_t row = item.get_group(0) * sg.get_group_linear_range() + sg.get_group_linear_id();
+                row < num_rows; row += num_sub_groups) {
+              T sum{0};
+              for(int k = offsets[row] + lane; k < offsets[row + 1]; k += sub_group_size)
+                sum += values[k] * x[columns[k]];
+              sum = sycl::reduce_over_group(sg, sum, sycl::plus<T>());
+              if(lane == 0)
+                y[row] = sum;
+            }
+          } else if constexpr(Format == SpMVFormat::ELLPACK) {
+            if(gid < num_rows) {
+              T sum{0};
+              for(std::size_t j = 0; j < ell_width; ++j)
+                sum += values[j * num_rows + gid] * x[columns[j * num_rows + gid]];
+              y[gid] = sum;
+            }
+          } else {
+            if(gid < num_rows) {
+              const std::size_t slice = gid / SELL_C;
+              const std::size_t lane = gid % SELL_C;
+              const int width = (offsets[slice + 1] - offsets[slice]) / SELL_C;
+
+              T sum{0};
+              for(int j = 0; j < width; ++j) {
+                const std::size_t k = offsets[slice] + j * SELL_C + lane;
+                sum += values[k] * x[columns[k]];
+              }
+              y[permutation[gid]] = sum;
+            }
+          }
+        });
+    })); // submit
+  }
+
+  bool verify(VerificationSetting &ver) {
+    const double tolerance = std::is_same_v<T, double> ? 1e-9 : 1e-3;
+
+    auto result = _y_buff.template get_access<sycl::access::mode::read>();
+    for(std::size_t row = 0; row < _args.problem_size; ++row) {
+      const double expected = _expected[row];
+      if(std::abs(result[row] - expected) > tolerance * std::max(std::abs(expected), 1.0))
+        return false;
+    }
+    return true;
+  }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs &args) const {
+    return {2.0 * _nnz / 1024.0 / 1024.0 / 1024.0, "GFLOP"};
+  }
+
+  static std::string getBenchmarkName() {
+    std::stringstream name;
+    name << "Pattern_SpMV_";
+    switch(Format) {
+    case SpMVFormat::CSRScalar: name << "CSRScalar_"; break;
+    case SpMVFormat::CSRVector: name << "CSRVector_"; break;
+    case SpMVFormat::ELLPACK: name << "ELLPACK_"; break;
+    case SpMVFormat::SELLCSigma: name << "SELL" << SELL_C << "Sigma" << SELL_SIGMA << "_"; break;
+    }
+    switch(Structure) {
+    case MatrixStructure::Banded: name << "Banded_"; break;
+    case MatrixStructure::RandomUniform: name << "RandomUniform_"; break;
+    case MatrixStructure::PowerLaw: name << "PowerLaw_"; break;
+    }
+    name << ReadableTypename<T>::name;
+    return name.str();
+  }
+
+private:
+  void convert_to_ellpack(const std::vector<int>& row_offsets, const std::vector<int>& columns,
+                          const std::vector<T>& values)
+  {
+    const std::size_t num_rows = _args.problem_size;
+    _ell_width = *std::max_element(_row_lengths.begin(), _row_lengths.end());
+
+    // Padding entries multiply zero with x[0]
+    _columns.assign(_ell_width * num_rows, 0);
+    _values.assign(_ell_width * num_rows, T{0});
+    for(std::size_t row = 0; row < num_rows; ++row) {
+      for(int k = row_offsets[row]; k < row_offsets[row + 1]; ++k) {
+        const std::size_t j = k - row_offsets[row];
+        _columns[j * num_rows + row] = columns[k];
+        _values[j * num_rows + row] = values[k];
+      }
+    }
+  }
+
+  void convert_to_sell(const std::vector<int>& row_offsets, const std::vector<int>& columns,
+                       const std::vector<T>& values)
+  {
+    const std::size_t num_rows = _args.problem_size;
+    const std::size_t num_slices = (num_rows + SELL_C - 1) / SELL_C;
+
+    // Sort the rows by descending length within every window, such that rows of similar length share a slice
+    _permutation.resize(num_rows);
+    std::iota(_permutation.begin(), _permutation.end(), 0);
+    for(std::size_t window = 0; window < num_rows; window += SELL_SIGMA) {
+      std::stable_sort(_permutation.begin() + window, _permutation.begin() + std::min(window + SELL_SIGMA, num_rows),
+                       [&](int a, int b) { return _row_lengths[a] > _row_lengths[b]; });
+    }
+
+    _offsets.resize(num_slices + 1);
+    _offsets[0] = 0;
+    for(std::size_t slice = 0; slice < num_slices; ++slice) {
+      std::size_t width = 0;
+      for(std::size_t i = slice * SELL_C; i < std::min((slice + 1) * SELL_C, num_rows); ++i)
+        width = std::max(width, _row_lengths[_permutation[i]]);
+      assert(_offsets[slice] + width * SELL_C <= static_cast<std::size_t>(std::numeric_limits<int>::max()) &&
+             "Too many padded non-zeros");
+      _offsets[slice + 1] = _offsets[slice] + static_cast<int>(width * SELL_C);
+    }
+
+    _columns.assign(_offsets[num_slices], 0);
+    _values.assign(_offsets[num_slices], T{0});
+    for(std::size_t i = 0; i < num_rows; ++i) {
+      const int row = _permutation[i];
+      const std::size_t slice = i / SELL_C;
+      const std::size_t lane = i % SELL_C;
+      for(int k = row_offsets[row]; k < row_offsets[row + 1]; ++k) {
+        const std::size_t j = k - row_offsets[row];
+        _columns[_offsets[slice] + j * SELL_C + lane] = columns[k];
+        _values[_offsets[slice] + j * SELL_C + lane] = values[k];
+      }
+    }
+  }
+};
+
+// Runs the benchmark and emits its effective bandwidth, the time of the conversion from CSR
+// and the throughput of a single SpMV including the conversion.
+template <typename T, SpMVFormat Format, MatrixStructure Structure>
+void runSpMV(BenchmarkApp& app)
+{
+  using Benchmark = SpMV<T, Format, Structure>;
+
+  if(Format == SpMVFormat::ELLPACK) {
+    const auto row_lengths = generateRowLengths(Structure, app.getArgs().problem_size);
+    const std::size_t nnz = std::accumulate(row_lengths.begin(), row_lengths.end(), std::size_t{0});
+    const std::size_t width = *std::max_element(row_lengths.begin(), row_lengths.end());
+    if(width * row_lengths.size() > MAX_ELLPACK_PADDING * nnz)
+      return;
+  }
+
+  SpMVStats stats;
+  const auto time = app.run<Benchmark>(stats);
+  if(!time)
+    return;
+
+  const double seconds = time->count() / 1.0e9;
+  const double gflop = Benchmark{app.getArgs(), stats}.getThroughputMetric(app.getArgs()).metric;
+  const double conversion_seconds = stats.conversion_time.count() / 1.0e9;
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark(Benchmark::getBenchmarkName() + "_Bandwidth");
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  consumer.consumeResult("effective-bandwidth", std::to_string(stats.bytes / 1024.0 / 1024.0 / 1024.0 / seconds),
+                         "GiB/s");
+  consumer.consumeResult("conversion-time", std::to_string(conversion_seconds * 1.0e3), "ms");
+  consumer.consumeResult("throughput-including-conversion", std::to_string(gflop / (seconds + conversion_seconds)),
+                         "GFLOP/s");
+  consumer.flush();
+}
+
+template <typename T, MatrixStructure Structure>
+void runFormats(BenchmarkApp& app)
+{
+  runSpMV<T, SpMVFormat::CSRScalar, Structure>(app);
+  runSpMV<T, SpMVFormat::CSRVector, Structure>(app);
+  runSpMV<T, SpMVFormat::ELLPACK, Structure>(app);
+  runSpMV<T, SpMVFormat::SELLCSigma, Structure>(app);
+}
+
+template <typename T>
+void runStructures(BenchmarkApp& app)
+{
+  runFormats<T, MatrixStructure::Banded>(app);
+  runFormats<T, MatrixStructure::RandomUniform>(app);
+  runFormats<T, MatrixStructure::PowerLaw>(app);
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  if(app.shouldRunNDRangeKernels()) {
+    runStructures<float>(app);
+    if(app.deviceSupportsFP64())
+      runStructures<double>(app);
+  }
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include "common.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+using namespace cl;
+
+template <std::size_t PayloadBytes, std::size_t NumAccessors>
+class LaunchLatencyKernel;
+
+// Kernel argument of the given size, captured by value by every launched kernel.
+template <std::size_t PayloadBytes>
+struct LaunchPayload {
+  unsigned char data[PayloadBytes];
+};
+
+// Measures the latency of launching <problem-size> kernels with empty work items back to back,
+// depending on the global range, the size of the lambda captures and the number of accessors.
+// All launches access the same buffers and therefore depend on each other, so the run time
+// divided by the number of launches is the time from one launch to the next.
+// As the work items are empty, the throughput in work items per second shows
+// the global range at which the launch cost stops dominating.
+template <std::size_t PayloadBytes, std::size_t NumAccessors>
+class LaunchLatency
+{
+  std::vector<PrefetchedBuffer<int, 1>> dummy_buffers;
+  BenchmarkArgs args;
+  const std::size_t global_range;
+  LaunchPayload<PayloadBytes> payload;
+
+  using AccessorT = sycl::accessor<int, 1, sycl::access::mode::read_write, sycl::access::target::global_buffer>;
+
+  template <std::size_t... Is>
+  std::array<AccessorT, NumAccessors> get_accessors(sycl::handler& cgh, std::index_sequence<Is...>)
+  {
+    return {dummy_buffers[Is].template get_access<sycl::access::mode::read_write>(cgh)...};
+  }
+
+public:
+  // All launches use basic ranges
+  static constexpr bool usesLocalSize = false;
+
+  LaunchLatency(const BenchmarkArgs& _args, std::size_t _global_range)
+  : args(_args), global_range(_global_range)
+  {}
+
+  void setup()
+  {
+    for(std::size_t i = 0; i < PayloadBytes; ++i)
+      payload.data[i] = static_cast<unsigned char>(i);
+
+    dummy_buffers.resize(NumAccessors);
+    for(auto& buffer : dummy_buffers)
+      buffer.initialize(args.device_queue, sycl::range<1>{1});
+  }
+
+  void run(std::vector<cl::sycl::event>& events)
+  {
+    for(std::size_t i = 0; i < args.problem_size; ++i) {
+      events.push_back(args.device_queue.submit(
+          [&](cl::sycl::handler& cgh) {
+        auto accs = get_accessors(cgh, std::make_index_sequence<NumAccessors>{});
+        const auto p = payload;
+
+        cgh.parallel_for<LaunchLatencyKernel<PayloadBytes, NumAccessors>>(
+          sycl::range<1>{global_range},
+          [=](sycl::id<1> idx)
+        {
+          if(idx[0] == 0) {
+            for(std::size_t a = 0; a < NumAccessors; ++a)
+              accs[a][0] = p.data[PayloadBytes - 1] + static_cast<int>(i);
+          }
+        });
+      })); // submit
+    }
+  }
+
+  bool verify(VerificationSetting &ver)
+  {
+    const int expected = static_cast<int>((PayloadBytes - 1) % 256) + static_cast<int>(args.problem_size - 1);
+    for(auto& buffer : dummy_buffers) {
+      auto host_acc = buffer.template get_access<sycl::access::mode::read>();
+      if(host_acc[0] != expected)
+        return false;
+    }
+    return true;
+  }
+
+  LatencyMetric getLatencyMetric(const BenchmarkArgs& args) const
+  {
+    return {static_cast<double>(args.problem_size), "launch"};
+  }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) const
+  {
+    return {static_cast<double>(args.problem_size) * global_range / 1.0e9, "Gitem"};
+  }
+
+  std::string getBenchmarkName() const
+  {
+    std::stringstream name;
+    name << "Runtime_LaunchLatency_";
+    name << "Range" << global_range << "_";
+    name << "Payload" << PayloadBytes << "B_";
+    name << "Accessors" << NumAccessors;
+    return name.str();
+  }
+};
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  // The largest global range can be changed using --max-global-range=<work items>.
+  const std::size_t max_global_range =
+      app.getArgs().cli.getOrDefault<std::size_t>("--max-global-range", std::size_t{1} << 24);
+
+  // Global range, with a minimal payload and a single accessor
+  for(std::size_t global_range = 1; global_range <= max_global_range; global_range *= 16)
+    app.run<LaunchLatency<8, 1>>(global_range);
+
+  const std::size_t single_item = 1;
+
+  // Size of the lambda captures. Note that some backends limit the size of
+  // kernel arguments (e.g. 4 KiB on CUDA), the largest payload may fail there.
+  app.run<LaunchLatency<64, 1>>(single_item);
+  app.run<LaunchLatency<512, 1>>(single_item);
+  app.run<LaunchLatency<1024, 1>>(single_item);
+  app.run<LaunchLatency<2048, 1>>(single_item);
+  app.run<LaunchLatency<4096, 1>>(single_item);
+
+  // Number of accessors
+  app.run<LaunchLatency<8, 2>>(single_item);
+  app.run<LaunchLatency<8, 4>>(single_item);
+  app.run<LaunchLatency<8, 8>>(single_item);
+  app.run<LaunchLatency<8, 16>>(single_item);
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "common.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace cl;
+
+// Whether the submitting host threads share the default queue, or each one uses its own queue
+// (in the same context and on the same device).
+enum class SubmissionQueueMode { Shared, PerThread };
+
+template <SubmissionQueueMode QueueMode> class MultiThreadedSubmissionKernel;
+
+// Host-side duration of every queue::submit() call of the last run, in nanoseconds.
+using SubmitLatencySamples = std::vector<double>;
+
+// Measures how the submission of independent kernels scales with the number of host threads submitting them.
+// Each of the <num-threads> threads submits <problem-size> trivial single_task kernels, each of which
+// writes to its own buffer, such that there are no dependencies between kernels.
+// This is mainly limited by synchronization within the SYCL runtime, e.g. locks guarding
+// the queue or the task graph.
+template <SubmissionQueueMode QueueMode>
+class MultiThreadedSubmission
+{
+  std::vector<sycl::buffer<int, 1>> dummy_buffers;
+  std::vector<sycl::queue> thread_queues;
+  BenchmarkArgs args;
+  const std::size_t num_threads;
+  SubmitLatencySamples& latency_samples;
+public:
+  // Only single_task kernels are submitted
+  static constexpr bool usesLocalSize = false;
+
+  MultiThreadedSubmission(const BenchmarkArgs &_args, std::size_t _num_threads, SubmitLatencySamples& samples)
+  : args(_args), num_threads(_num_threads), latency_samples(samples)
+  {}
+
+  void setup()
+  {
+    for (std::size_t i = 0; i < num_threads * args.problem_size; ++i) {
+      dummy_buffers.push_back(sycl::buffer<int, 1>{sycl::range<1>{1}});
+      forceDataAllocation(args.device_queue, dummy_buffers.back());
+    }
+
+    for (std::size_t t = 0; t < num_threads; ++t) {
+      if(QueueMode == SubmissionQueueMode::Shared)
+        thread_queues.push_back(args.device_queue);
+      else
+        thread_queues.push_back(
+            sycl::queue{args.device_queue.get_context(), args.device_queue.get_device()});
+    }
+
+    latency_samples.assign(num_threads * args.problem_size, 0.0);
+  }
+
+  void submit(std::size_t thread_id)
+  {
+    sycl::queue& q = thread_queues[thread_id];
+
+    for(std::size_t i = 0; i < args.problem_size; ++i) {
+      const std::size_t task_id = thread_id * args.problem_size + i;
+
+      const auto before = std::chrono::high_resolution_clock::now();
+      q.submit(
+          [&](cl::sycl::handler& cgh) {
+        auto acc = dummy_buffers[task_id].get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.single_task<MultiThreadedSubmissionKernel<QueueMode>>(
+          [=]()
+        {
+          acc[0] = static_cast<int>(task_id);
+        });
+      }); // submit
+      const auto after = std::chrono::high_resolution_clock::now();
+
+      latency_samples[task_id] = std::chrono::duration<double, std::nano>(after - before).count();
+    }
+  }
+
+  void run()
+  {
+    std::vector<std::thread> threads;
+    for(std::size_t t = 0; t < num_threads; ++t)
+      threads.emplace_back([this, t]() { submit(t); });
+
+    for(auto& thread : threads)
+      thread.join();
+
+    // The BenchmarkManager only waits for the default queue
+    if(QueueMode == SubmissionQueueMode::PerThread) {
+      for(auto& q : thread_queues)
+        q.wait_and_throw();
+    }
+  }
+
+  bool verify(VerificationSetting &ver)
+  {
+    for(std::size_t i = 0; i < dummy_buffers.size(); ++i){
+      auto host_acc =
+        dummy_buffers[i].get_access<sycl::access::mode::read>();
+
+      if(host_acc[0] != static_cast<int>(i))
+        return false;
+    }
+
+    return true;
+  }
+
+  ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) const
+  {
+    return {static_cast<double>(num_threads * args.problem_size), "submissions"};
+  }
+
+  static std::string getQueueModeName()
+  {
+    return QueueMode == SubmissionQueueMode::Shared ? "SharedQueue" : "PerThreadQueue";
+  }
+
+  std::string getBenchmarkName() const
+  {
+    std::stringstream name;
+    name << "Runtime_MultiThreadedSubmission_";
+    name << getQueueModeName() << "_";
+    name << num_threads << "Threads";
+    return name.str();
+  }
+};
+
+// Runs the benchmark for the given number of threads and emits the percentiles
+// of the host-side submission latency of the last run.
+template <SubmissionQueueMode QueueMode>
+void runWithThreads(BenchmarkApp& app, std::size_t num_threads)
+{
+  SubmitLatencySamples samples;
+  if(!app.run<MultiThreadedSubmission<QueueMode>>(num_threads, samples) || samples.empty())
+    return;
+
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&](double p) {
+    const std::size_t idx = std::min(samples.size() - 1, static_cast<std::size_t>(p * samples.size()));
+    return std::to_string(samples[idx]);
+  };
+
+  auto& consumer = *app.getArgs().result_consumer;
+  consumer.proceedToBenchmark(
+      MultiThreadedSubmission<QueueMode>{app.getArgs(), num_threads, samples}.getBenchmarkName() + "_SubmitLatency");
+  consumer.consumeResult("problem-size", std::to_string(app.getArgs().problem_size));
+  consumer.consumeResult("submit-latency-p50", percentile(0.5), "ns");
+  consumer.consumeResult("submit-latency-p90", percentile(0.9), "ns");
+  consumer.consumeResult("submit-latency-p99", percentile(0.99), "ns");
+  consumer.consumeResult("submit-latency-max", std::to_string(samples.back()), "ns");
+  consumer.flush();
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkApp app(argc, argv);
+
+  // The largest number of threads can be changed using --max-threads=<T>.
+  const std::size_t max_threads = app.getArgs().cli.getOrDefault<std::size_t>(
+      "--max-threads", std::max<std::size_t>(std::thread::hardware_concurrency(), 1));
+
+  for(std::size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    runWithThreads<SubmissionQueueMode::Shared>(app, num_threads);
+    runWithThreads<SubmissionQueueMode::PerThread>(app, num_threads);
+  }
+
+  return 0;
+}